@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include "autosave.h"
+
+typedef std::chrono::steady_clock Clock;
+
+const uint32_t JOURNAL_MAGIC = 0x4c4e524a;  // "JRNL"
+
+// Writes of a column before it is left to the journal, and the pause between them
+const int WRITE_ATTEMPTS = 3;
+const std::chrono::milliseconds RETRY_DELAY(1000);
+
+// FNV-1a, enough to spot a torn journal record
+static uint32_t checksum(const unsigned char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+static uint64_t columnKey(int chunkX, int chunkZ) {
+    return packChunkKey(chunkX, 0, chunkZ);
+}
+
+WorldSaver::WorldSaver(RegionStore& store, int minChunkY, int maxChunkY, int workerCount)
+    : store(store), minChunkY(minChunkY), maxChunkY(maxChunkY), journalPath(store.path() + "/journal.log") {
+    replayJournal();
+    for (int i = 0; i < std::max(1, workerCount); ++i)
+        workers.emplace_back(&WorldSaver::workerLoop, this);
+    writer = std::thread(&WorldSaver::writerLoop, this);
+}
+
+WorldSaver::WorldSaver(RegionStore& store, int minChunkY, int maxChunkY, JobSystem& jobs)
+    : store(store), jobs(&jobs), minChunkY(minChunkY), maxChunkY(maxChunkY), journalPath(store.path() + "/journal.log") {
+    replayJournal();
+    writer = std::thread(&WorldSaver::writerLoop, this);
+}
+
+WorldSaver::~WorldSaver() {
+    flush();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    workReady.notify_all();
+    writeReady.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+    writer.join();
+}
+
+void WorldSaver::submit(World& world, const std::vector<glm::ivec2>& columns) {
+    Clock::time_point start = Clock::now();
+    std::vector<std::shared_ptr<Snapshot>> snapshots;
+    for (const glm::ivec2& column : columns) {
+        bool unsaved = false;
+        for (int y = minChunkY; y <= maxChunkY && !unsaved; ++y) {
+            const Chunk* chunk = world.getChunk(column.x, y, column.y);
+            unsaved = chunk && chunk->unsaved;
+        }
+        if (!unsaved)
+            continue;  // also skips a column listed twice
+
+        std::shared_ptr<Snapshot> snapshot(new Snapshot());
+        snapshot->chunkX = column.x;
+        snapshot->chunkZ = column.y;
+        for (int y = minChunkY; y <= maxChunkY; ++y) {
+            Chunk* chunk = world.getChunk(column.x, y, column.y);
+            if (!chunk)
+                continue;
+            snapshot->sections.push_back(ColumnSection{ y, chunk->snapshot().blocks });
+            chunk->unsaved = false;
+        }
+        snapshots.push_back(snapshot);
+    }
+    if (snapshots.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (inFlight == 0)
+            busySince = Clock::now();
+        for (const std::shared_ptr<Snapshot>& snapshot : snapshots) {
+            pending[columnKey(snapshot->chunkX, snapshot->chunkZ)] = snapshot;
+            if (!jobs)
+                compressQueue.push_back(snapshot);
+            ++inFlight;
+        }
+        ++totals.snapshots;
+        totals.snapshotMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+    if (!jobs) {
+        workReady.notify_all();
+        return;
+    }
+    for (const std::shared_ptr<Snapshot>& snapshot : snapshots) {
+        std::shared_ptr<const Snapshot> queued = snapshot;
+        jobs->submit([this, queued]() { encode(queued); });
+    }
+}
+
+void WorldSaver::saveUnsaved(World& world) {
+    std::vector<glm::ivec2> columns;
+    for (int i = 0; i < world.chunkCapacity(); ++i)
+        if (world.isLoaded(i) && world.chunk(i).unsaved)
+            columns.push_back(glm::ivec2(world.chunkCoord(i).x, world.chunkCoord(i).z));
+    submit(world, columns);
+}
+
+bool WorldSaver::loadColumn(World& world, int chunkX, int chunkZ, std::vector<int>& added) {
+    std::shared_ptr<const Snapshot> snapshot;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto found = pending.find(columnKey(chunkX, chunkZ));
+        if (found != pending.end())
+            snapshot = found->second;
+    }
+    if (!snapshot)
+        return store.loadColumn(world, chunkX, chunkZ, added);
+
+    for (const ColumnSection& section : snapshot->sections) {
+        if (world.findChunk(chunkX, section.chunkY, chunkZ) >= 0)
+            continue;
+        int index = world.addChunk(chunkX, section.chunkY, chunkZ);
+        Chunk& chunk = world.chunk(index);
+        chunk.replaceBlocks(BlockStorage(*section.blocks));
+        chunk.dirty = true;
+        chunk.unsaved = false;  // the queued snapshot already holds these blocks
+        added.push_back(index);
+    }
+    return true;
+}
+
+void WorldSaver::flush() {
+    std::unique_lock<std::mutex> guard(lock);
+    idle.wait(guard, [this] { return inFlight == 0; });
+}
+
+SaveStats WorldSaver::stats() const {
+    std::lock_guard<std::mutex> guard(lock);
+    SaveStats current = totals;
+    if (inFlight > 0)
+        current.busySeconds += std::chrono::duration<double>(Clock::now() - busySince).count();
+    return current;
+}
+
+void WorldSaver::workerLoop() {
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+        workReady.wait(guard, [this] { return stopping || !compressQueue.empty(); });
+        if (compressQueue.empty())
+            return;
+        std::shared_ptr<const Snapshot> snapshot = compressQueue.front();
+        compressQueue.pop_front();
+        guard.unlock();
+        encode(snapshot);
+        guard.lock();
+    }
+}
+
+// Compresses one snapshot and hands it to the writer
+void WorldSaver::encode(const std::shared_ptr<const Snapshot>& snapshot) {
+    Encoded encoded;
+    encoded.snapshot = snapshot;
+    encoded.decodedSize = encodeColumn(snapshot->sections, encoded.payload);
+
+    std::lock_guard<std::mutex> guard(lock);
+    writeQueue.push_back(std::move(encoded));
+    writeReady.notify_one();
+}
+
+void WorldSaver::writerLoop() {
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+        // Failed columns go again after a pause, along with whatever was queued meanwhile
+        if (retryQueue.empty())
+            writeReady.wait(guard, [this] { return stopping || !writeQueue.empty(); });
+        else
+            writeReady.wait_for(guard, RETRY_DELAY, [this] { return stopping; });
+        if (writeQueue.empty() && retryQueue.empty())
+            return;
+        std::vector<Encoded> batch;
+        batch.swap(retryQueue);
+        for (Encoded& encoded : writeQueue)
+            batch.push_back(std::move(encoded));
+        writeQueue.clear();
+
+        // Workers can finish out of order; only the newest snapshot of a column is written
+        std::vector<Encoded> newest;
+        for (Encoded& encoded : batch) {
+            auto found = pending.find(columnKey(encoded.snapshot->chunkX, encoded.snapshot->chunkZ));
+            if (found != pending.end() && found->second == encoded.snapshot)
+                newest.push_back(std::move(encoded));
+        }
+        guard.unlock();
+
+        bool written = writeBatch(newest);
+
+        guard.lock();
+        for (Encoded& encoded : newest) {
+            uint64_t key = columnKey(encoded.snapshot->chunkX, encoded.snapshot->chunkZ);
+            if (!written) {
+                if (++encoded.attempts < WRITE_ATTEMPTS) {
+                    retryQueue.push_back(std::move(encoded));
+                    continue;
+                }
+                // Stays in pending so loads still see it, and in the journal for the next start-up
+                std::cerr << "Failed to save column (" << encoded.snapshot->chunkX << ", " << encoded.snapshot->chunkZ
+                          << ") after " << WRITE_ATTEMPTS << " attempts; keeping the save journal\n";
+                unwritten.insert(key);
+                continue;
+            }
+            auto found = pending.find(key);
+            if (found != pending.end() && found->second == encoded.snapshot)
+                pending.erase(found);
+            unwritten.erase(key);
+            ++totals.columnsSaved;
+            totals.chunksSaved += encoded.snapshot->sections.size();
+            totals.encodedBytes += encoded.decodedSize;
+            totals.writtenBytes += encoded.payload.size();
+        }
+
+        // The journal goes once no journaled column is left unwritten
+        if (written && retryQueue.empty() && unwritten.empty())
+            clearJournal();
+
+        inFlight -= (int)(batch.size() - retryQueue.size());
+        if (inFlight == 0) {
+            totals.busySeconds += std::chrono::duration<double>(Clock::now() - busySince).count();
+            idle.notify_all();
+        }
+    }
+}
+
+// Journal record: magic, chunk x, chunk z, payload size, payload checksum, payload
+bool WorldSaver::writeBatch(const std::vector<Encoded>& batch) {
+    if (batch.empty())
+        return true;
+
+    std::FILE* journal = std::fopen(journalPath.c_str(), "ab");
+    if (!journal) {
+        std::cerr << "Failed to open save journal: " << journalPath << "\n";
+        return false;
+    }
+    for (const Encoded& encoded : batch) {
+        uint32_t header[5] = { JOURNAL_MAGIC, (uint32_t)encoded.snapshot->chunkX, (uint32_t)encoded.snapshot->chunkZ,
+                               (uint32_t)encoded.payload.size(), checksum(encoded.payload.data(), encoded.payload.size()) };
+        std::fwrite(header, sizeof(header), 1, journal);
+        std::fwrite(encoded.payload.data(), 1, encoded.payload.size(), journal);
+    }
+    bool journaled = syncFile(journal);
+    std::fclose(journal);
+    if (!journaled)
+        return false;
+
+    bool ok = true;
+    for (const Encoded& encoded : batch)
+        ok = store.writeColumn(encoded.snapshot->chunkX, encoded.snapshot->chunkZ, encoded.payload.data(), encoded.payload.size()) && ok;
+    return store.sync() && ok;
+}
+
+void WorldSaver::clearJournal() {
+    std::FILE* journal = std::fopen(journalPath.c_str(), "wb");
+    if (journal)
+        std::fclose(journal);
+}
+
+void WorldSaver::replayJournal() {
+    std::FILE* journal = std::fopen(journalPath.c_str(), "rb");
+    if (!journal)
+        return;
+    std::vector<unsigned char> contents;
+    unsigned char buffer[1 << 16];
+    size_t got;
+    while ((got = std::fread(buffer, 1, sizeof(buffer), journal)) > 0)
+        contents.insert(contents.end(), buffer, buffer + got);
+    std::fclose(journal);
+
+    // Records up to the first torn or damaged one are complete and safe to reapply
+    size_t offset = 0, replayed = 0;
+    while (offset + 20 <= contents.size()) {
+        uint32_t header[5];
+        std::memcpy(header, contents.data() + offset, sizeof(header));
+        const unsigned char* payload = contents.data() + offset + 20;
+        if (header[0] != JOURNAL_MAGIC || header[3] > contents.size() - offset - 20 ||
+            checksum(payload, header[3]) != header[4])
+            break;
+        store.writeColumn((int)header[1], (int)header[2], payload, header[3]);
+        offset += 20 + header[3];
+        ++replayed;
+    }
+    if (!store.sync())
+        return;
+
+    clearJournal();
+    if (replayed > 0)
+        std::cout << "Replayed " << replayed << " columns from the save journal\n";
+}
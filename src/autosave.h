@@ -0,0 +1,100 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <glm/glm.hpp>
+#include "jobs.h"
+#include "region.h"
+#include "world.h"
+
+struct SaveStats {
+    uint64_t columnsSaved = 0;
+    uint64_t chunksSaved = 0;
+    uint64_t encodedBytes = 0;  // before compression
+    uint64_t writtenBytes = 0;  // compressed bytes that reached the regions
+    double busySeconds = 0.0;   // wall time with saves queued or running
+
+    uint64_t snapshots = 0;     // submit() calls that queued anything
+    double snapshotMs = 0.0;    // caller time spent taking those snapshots
+
+    double chunksPerSecond() const { return busySeconds > 0.0 ? chunksSaved / busySeconds : 0.0; }
+    double megabytesPerSecond() const { return busySeconds > 0.0 ? writtenBytes / busySeconds / (1024.0 * 1024.0) : 0.0; }
+    double snapshotMsAverage() const { return snapshots ? snapshotMs / snapshots : 0.0; }
+};
+
+// === Background saving ===
+// The caller only takes copy-on-write snapshots of changed columns. Worker
+// threads compress the snapshots, and a single writer thread appends each batch
+// to a write-ahead journal, syncs it, then writes and syncs the regions
+// before clearing the journal. A journal left behind by a crash is replayed
+// on start-up, so a region is never left half-updated. Given a JobSystem,
+// the compression runs as jobs on it instead of on the saver's own workers.
+// A batch that fails to write is retried a few times; a column still unwritten
+// after that stays readable from its snapshot, and the journal is kept until
+// a newer copy of it is written, so the next start-up replays it.
+class WorldSaver {
+public:
+    WorldSaver(RegionStore& store, int minChunkY, int maxChunkY, int workerCount = 2);
+    WorldSaver(RegionStore& store, int minChunkY, int maxChunkY, JobSystem& jobs);
+    ~WorldSaver();  // finishes everything queued
+
+    // Snapshots the given columns that hold unsaved chunks and queues them
+    void submit(World& world, const std::vector<glm::ivec2>& columns);
+    // Queues every loaded column with an unsaved chunk
+    void saveUnsaved(World& world);
+
+    // RegionStore::loadColumn, except that a column still waiting to be
+    // written comes from its snapshot rather than the older copy on disk
+    bool loadColumn(World& world, int chunkX, int chunkZ, std::vector<int>& added);
+
+    // Blocks until everything queued so far is on disk
+    void flush();
+    SaveStats stats() const;
+
+private:
+    struct Snapshot {
+        int chunkX, chunkZ;
+        std::vector<ColumnSection> sections;
+    };
+    struct Encoded {
+        std::shared_ptr<const Snapshot> snapshot;
+        std::vector<unsigned char> payload;
+        size_t decodedSize;
+        int attempts = 0;  // failed writes so far
+    };
+
+    void encode(const std::shared_ptr<const Snapshot>& snapshot);
+    void workerLoop();
+    void writerLoop();
+    bool writeBatch(const std::vector<Encoded>& batch);
+    void replayJournal();
+    void clearJournal();
+
+    RegionStore& store;
+    JobSystem* jobs = nullptr;
+    int minChunkY, maxChunkY;
+    std::string journalPath;
+
+    mutable std::mutex lock;
+    std::condition_variable workReady, writeReady, idle;
+    std::deque<std::shared_ptr<const Snapshot>> compressQueue;
+    std::vector<Encoded> writeQueue;
+    std::vector<Encoded> retryQueue;  // failed writes, still pending and in flight
+    std::unordered_map<uint64_t, std::shared_ptr<const Snapshot>> pending;  // newest snapshot per column until written
+    std::unordered_set<uint64_t> unwritten;  // columns given up on; only the journal has them
+    int inFlight = 0;
+    bool stopping = false;
+    std::chrono::steady_clock::time_point busySince;
+    SaveStats totals;
+
+    std::vector<std::thread> workers;
+    std::thread writer;
+};
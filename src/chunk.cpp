@@ -0,0 +1,375 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include "chunk.h"
+#include "compress.h"
+
+static std::atomic<uint64_t> compressionCount(0);
+static std::atomic<uint64_t> decompressionCount(0);
+static std::atomic<uint64_t> decompressNanos(0);
+static std::atomic<uint64_t> idleHitCount(0);
+
+// Widths that divide 64, so an index never straddles two words
+static int bitsForPalette(int size) {
+    if (size <= 1) return 0;
+    if (size <= 2) return 1;
+    if (size <= 4) return 2;
+    if (size <= 16) return 4;
+    if (size <= 256) return 8;
+    return 16;
+}
+
+template <typename Layout>
+BasicBlockStorage<Layout>::BasicBlockStorage(int block) : uniform(block) {
+}
+
+// Spelled out because the access state is atomic
+template <typename Layout>
+BasicBlockStorage<Layout>::BasicBlockStorage(const BasicBlockStorage& other)
+    : palette(other.palette), words(other.words), compressedWords(other.compressedWords),
+      bits(other.bits), uniform(other.uniform), access(other.access.load(std::memory_order_relaxed)) {
+}
+
+template <typename Layout>
+BasicBlockStorage<Layout>::BasicBlockStorage(BasicBlockStorage&& other) noexcept
+    : palette(std::move(other.palette)), words(std::move(other.words)),
+      compressedWords(std::move(other.compressedWords)), bits(other.bits), uniform(other.uniform),
+      access(other.access.load(std::memory_order_relaxed)) {
+}
+
+template <typename Layout>
+BasicBlockStorage<Layout>& BasicBlockStorage<Layout>::operator=(const BasicBlockStorage& other) {
+    palette = other.palette;
+    words = other.words;
+    compressedWords = other.compressedWords;
+    bits = other.bits;
+    uniform = other.uniform;
+    access.store(other.access.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return *this;
+}
+
+template <typename Layout>
+BasicBlockStorage<Layout>& BasicBlockStorage<Layout>::operator=(BasicBlockStorage&& other) noexcept {
+    palette = std::move(other.palette);
+    words = std::move(other.words);
+    compressedWords = std::move(other.compressedWords);
+    bits = other.bits;
+    uniform = other.uniform;
+    access.store(other.access.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return *this;
+}
+
+template <typename Layout>
+void BasicBlockStorage<Layout>::writeIndex(int i, int paletteIndex) {
+    int bit = i * bits;
+    uint64_t mask = ((1ull << bits) - 1) << (bit & 63);
+    uint64_t& word = words[bit >> 6];
+    word = (word & ~mask) | ((uint64_t)paletteIndex << (bit & 63));
+}
+
+// Re-encodes every index at a new, wider width
+template <typename Layout>
+void BasicBlockStorage<Layout>::setBits(int newBits) {
+    touch();
+    std::vector<int> indices(CHUNK_VOLUME, 0);
+    if (bits > 0)
+        for (int i = 0; i < CHUNK_VOLUME; ++i)
+            indices[i] = readIndex(i);
+
+    bits = newBits;
+    words.assign(CHUNK_VOLUME * bits / 64, 0);
+    for (int i = 0; i < CHUNK_VOLUME; ++i)
+        writeIndex(i, indices[i]);
+}
+
+template <typename Layout>
+void BasicBlockStorage<Layout>::set(int x, int y, int z, int block) {
+    touch();
+    if (bits == 0) {
+        if (block == uniform)
+            return;
+        // First differing write: every existing block becomes palette entry 0
+        palette.assign(1, uniform);
+    }
+
+    int paletteIndex = 0;
+    while (paletteIndex < (int)palette.size() && palette[paletteIndex] != block)
+        ++paletteIndex;
+
+    if (paletteIndex == (int)palette.size()) {
+        palette.push_back(block);
+        int needed = bitsForPalette((int)palette.size());
+        if (needed != bits)
+            setBits(needed);
+    }
+    writeIndex(index(x, y, z), paletteIndex);
+}
+
+template <typename Layout>
+void BasicBlockStorage<Layout>::fill(int block) {
+    std::vector<int>().swap(palette);
+    std::vector<uint64_t>().swap(words);
+    std::vector<unsigned char>().swap(compressedWords);
+    access = ACCESS_USED;
+    bits = 0;
+    uniform = block;
+}
+
+template <typename Layout>
+void BasicBlockStorage<Layout>::reset(int block) {
+    palette.clear();
+    words.clear();
+    compressedWords.clear();
+    bits = 0;
+    uniform = block;
+    access = ACCESS_USED;
+}
+
+template <typename Layout>
+void BasicBlockStorage<Layout>::unpack(int* out) const {
+    if (bits == 0) {
+        for (int i = 0; i < CHUNK_VOLUME; ++i)
+            out[i] = uniform;
+        return;
+    }
+
+    touch();
+
+    // Walk whole words rather than decoding each index from scratch
+    const int perWord = 64 / bits;
+    const uint64_t mask = (1ull << bits) - 1;
+    int i = 0;
+    for (uint64_t word : words) {
+        for (int k = 0; k < perWord; ++k, word >>= bits)
+            out[i++] = palette[word & mask];
+    }
+}
+
+template <typename Layout>
+void BasicBlockStorage<Layout>::pack(const int* in) {
+    palette.clear();
+    std::vector<unsigned char>().swap(compressedWords);
+    access = ACCESS_USED;
+    uint16_t indices[CHUNK_VOLUME];
+    int last = 0;  // runs of the same id are the common case
+    for (int i = 0; i < CHUNK_VOLUME; ++i) {
+        if (palette.empty() || palette[last] != in[i]) {
+            last = 0;
+            while (last < (int)palette.size() && palette[last] != in[i])
+                ++last;
+            if (last == (int)palette.size())
+                palette.push_back(in[i]);
+        }
+        indices[i] = (uint16_t)last;
+    }
+
+    if (palette.size() == 1) {
+        fill(palette[0]);
+        return;
+    }
+
+    bits = bitsForPalette((int)palette.size());
+    words.assign(CHUNK_VOLUME * bits / 64, 0);
+    for (int i = 0; i < CHUNK_VOLUME; ++i)
+        words[(i * bits) >> 6] |= (uint64_t)indices[i] << ((i * bits) & 63);
+}
+
+template <typename Layout>
+void BasicBlockStorage<Layout>::write(std::vector<unsigned char>& out) const {
+    touch();
+    uint8_t width = (uint8_t)bits;
+    uint16_t paletteCount = (uint16_t)paletteSize();
+    size_t start = out.size();
+    out.resize(start + 3 + paletteCount * sizeof(int32_t) + words.size() * sizeof(uint64_t));
+
+    unsigned char* dst = out.data() + start;
+    *dst++ = width;
+    std::memcpy(dst, &paletteCount, 2);
+    dst += 2;
+    if (bits == 0) {
+        int32_t block = uniform;
+        std::memcpy(dst, &block, sizeof(block));
+        return;
+    }
+    std::memcpy(dst, palette.data(), palette.size() * sizeof(int32_t));
+    dst += palette.size() * sizeof(int32_t);
+    std::memcpy(dst, words.data(), words.size() * sizeof(uint64_t));
+}
+
+template <typename Layout>
+size_t BasicBlockStorage<Layout>::read(const unsigned char* data, size_t size) {
+    if (size < 3)
+        return 0;
+    int width = data[0];
+    uint16_t paletteCount;
+    std::memcpy(&paletteCount, data + 1, 2);
+    if (width != bitsForPalette(paletteCount) || paletteCount == 0)
+        return 0;
+
+    size_t wordCount = (size_t)CHUNK_VOLUME * width / 64;
+    size_t needed = 3 + paletteCount * sizeof(int32_t) + wordCount * sizeof(uint64_t);
+    if (size < needed)
+        return 0;
+
+    const unsigned char* src = data + 3;
+    if (width == 0) {
+        int32_t block;
+        std::memcpy(&block, src, sizeof(block));
+        fill(block);
+        return needed;
+    }
+
+    const unsigned char* wordBytes = src + paletteCount * sizeof(int32_t);
+    if (paletteCount < (1 << width)) {
+        // A partly used width can encode indices past the palette
+        const int perWord = 64 / width;
+        const uint64_t mask = (1ull << width) - 1;
+        for (size_t w = 0; w < wordCount; ++w) {
+            uint64_t word;
+            std::memcpy(&word, wordBytes + w * sizeof(uint64_t), sizeof(word));
+            for (int k = 0; k < perWord; ++k, word >>= width)
+                if ((word & mask) >= paletteCount)
+                    return 0;
+        }
+    }
+
+    // assign/resize rather than fresh vectors, so recycled storage keeps its buffers
+    palette.resize(paletteCount);
+    std::memcpy(palette.data(), src, paletteCount * sizeof(int32_t));
+    words.resize(wordCount);
+    std::memcpy(words.data(), wordBytes, wordCount * sizeof(uint64_t));
+    compressedWords.clear();
+    access = ACCESS_USED;
+    bits = width;
+    return needed;
+}
+
+template <typename Layout>
+size_t BasicBlockStorage<Layout>::memoryUsage() const {
+    return sizeof(BasicBlockStorage) + palette.capacity() * sizeof(int) + words.capacity() * sizeof(uint64_t) +
+           compressedWords.capacity();
+}
+
+template <typename Layout>
+void BasicBlockStorage<Layout>::compress() {
+    if (bits == 0 || !compressedWords.empty())
+        return;
+    std::vector<unsigned char> packed;
+    lzCompress((const unsigned char*)words.data(), words.size() * sizeof(uint64_t), packed);
+    if (packed.size() >= words.size() * sizeof(uint64_t))
+        return;  // noise-like indices: not worth it
+    packed.shrink_to_fit();
+    compressedWords.swap(packed);
+    std::vector<uint64_t>().swap(words);
+    access = ACCESS_IDLE;
+    ++compressionCount;
+}
+
+template <typename Layout>
+void BasicBlockStorage<Layout>::inflate() const {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    words.resize(CHUNK_VOLUME * bits / 64);
+    lzDecompress(compressedWords.data(), compressedWords.size(),
+                 (unsigned char*)words.data(), words.size() * sizeof(uint64_t));
+    std::vector<unsigned char>().swap(compressedWords);
+    access.store(ACCESS_USED, std::memory_order_relaxed);
+    ++decompressionCount;
+    decompressNanos += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+template <typename Layout>
+void BasicBlockStorage<Layout>::markUsed() const {
+    if (access.exchange(ACCESS_USED, std::memory_order_relaxed) == ACCESS_IDLE)
+        ++idleHitCount;
+}
+
+// Only the sweep moves the state away from ACCESS_USED, so a failed exchange
+// means an access came in between and the blocks were used after all
+template <typename Layout>
+bool BasicBlockStorage<Layout>::takeReferenced() {
+    uint8_t seen = access.load(std::memory_order_relaxed);
+    while (!access.compare_exchange_weak(seen, seen == ACCESS_USED ? ACCESS_SWEPT : ACCESS_IDLE,
+                                         std::memory_order_relaxed)) {
+    }
+    return seen == ACCESS_USED;
+}
+
+// Built for every layout; CHUNK_LAYOUT picks the one chunks use
+template class BasicBlockStorage<LayoutXYZ>;
+template class BasicBlockStorage<LayoutXZY>;
+template class BasicBlockStorage<LayoutYZX>;
+template class BasicBlockStorage<LayoutMorton>;
+
+ColdStorageStats coldStorageStats() {
+    ColdStorageStats stats;
+    stats.compressions = compressionCount;
+    stats.decompressions = decompressionCount;
+    stats.idleHits = idleHitCount;
+    stats.decompressMicros = decompressNanos / 1000.0;
+    return stats;
+}
+
+Chunk::Chunk() {
+    int dense[CHUNK_VOLUME];
+    for (int x = 0; x < CHUNK_SIZE; ++x)
+        for (int y = 0; y < CHUNK_SIZE; ++y)
+            for (int z = 0; z < CHUNK_SIZE; ++z)
+                dense[BlockStorage::index(x, y, z)] = (y < CHUNK_SIZE / 2) ? 1 : 0;  // simple terrain
+    storage = std::make_shared<SharedBlocks>();
+    storage->blocks.pack(dense);
+}
+
+Chunk::Chunk(const Chunk& other)
+    : dirty(other.dirty), unsaved(other.unsaved), storage(std::make_shared<SharedBlocks>(other.blocks())),
+      blockVersion(other.blockVersion) {
+}
+
+Chunk& Chunk::operator=(const Chunk& other) {
+    if (this != &other) {
+        dirty = other.dirty;
+        unsaved = other.unsaved;
+        storage = std::make_shared<SharedBlocks>(other.blocks());
+        blockVersion = std::max(blockVersion, other.blockVersion) + 1;  // newer than any earlier snapshot of this chunk
+    }
+    return *this;
+}
+
+BlockStorage& Chunk::editBlocks() {
+    if (isShared())
+        storage = std::make_shared<SharedBlocks>(storage->blocks);
+    ++blockVersion;
+    return storage->blocks;
+}
+
+void Chunk::replaceBlocks(BlockStorage&& blocks) {
+    if (isShared())
+        storage = std::make_shared<SharedBlocks>(std::move(blocks));
+    else
+        storage->blocks = std::move(blocks);
+    ++blockVersion;
+}
+
+void Chunk::resetBlocks(int block) {
+    if (isShared())
+        storage = std::make_shared<SharedBlocks>(block);
+    else
+        storage->blocks.reset(block);
+    ++blockVersion;
+}
+
+// Readers on other threads must never inflate, so the storage is shared
+// decompressed, and compressBlocks() skips it for as long as it stays shared.
+// Copies of one snapshot share its lease; it ends when the last one goes.
+ChunkSnapshot Chunk::snapshot() const {
+    storage->blocks.decompress();
+    storage->readers.fetch_add(1, std::memory_order_relaxed);
+    std::shared_ptr<SharedBlocks> holder = storage;
+    ChunkSnapshot snap;
+    snap.blocks = std::shared_ptr<const BlockStorage>(&holder->blocks, [holder](const BlockStorage*) {
+        holder->readers.fetch_sub(1, std::memory_order_release);
+    });
+    snap.version = blockVersion;
+    return snap;
+}
@@ -0,0 +1,242 @@
+#pragma once
+#include <cstddef>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+const int CHUNK_SIZE = 16;
+const int CHUNK_VOLUME = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+
+// === In-chunk block order ===
+// A layout numbers the blocks of a chunk; storage, dense arrays from unpack()
+// and saved columns all follow it. Linear layouts are named from the outermost
+// axis to the innermost, so XZY keeps each vertical column contiguous.
+struct LayoutXYZ {
+    static const int id = 0;
+    static const char* name() { return "XYZ"; }
+    static int index(int x, int y, int z) { return (x * CHUNK_SIZE + y) * CHUNK_SIZE + z; }
+    static void coords(int i, int& x, int& y, int& z) {
+        x = i / (CHUNK_SIZE * CHUNK_SIZE);
+        y = (i / CHUNK_SIZE) % CHUNK_SIZE;
+        z = i % CHUNK_SIZE;
+    }
+};
+
+struct LayoutXZY {
+    static const int id = 1;
+    static const char* name() { return "XZY"; }
+    static int index(int x, int y, int z) { return (x * CHUNK_SIZE + z) * CHUNK_SIZE + y; }
+    static void coords(int i, int& x, int& y, int& z) {
+        x = i / (CHUNK_SIZE * CHUNK_SIZE);
+        z = (i / CHUNK_SIZE) % CHUNK_SIZE;
+        y = i % CHUNK_SIZE;
+    }
+};
+
+struct LayoutYZX {
+    static const int id = 2;
+    static const char* name() { return "YZX"; }
+    static int index(int x, int y, int z) { return (y * CHUNK_SIZE + z) * CHUNK_SIZE + x; }
+    static void coords(int i, int& x, int& y, int& z) {
+        y = i / (CHUNK_SIZE * CHUNK_SIZE);
+        z = (i / CHUNK_SIZE) % CHUNK_SIZE;
+        x = i % CHUNK_SIZE;
+    }
+};
+
+// Z-order: the bits of x, y and z interleaved, so any 2x2x2 (4x4x4, ...)
+// aligned cube is contiguous whichever axis a loop walks
+struct LayoutMorton {
+    static const int id = 3;
+    static const char* name() { return "Morton"; }
+    static int spread(int v) { return (v & 1) | (v & 2) << 2 | (v & 4) << 4 | (v & 8) << 6; }
+    static int compact(int v) { return (v & 1) | (v >> 2 & 2) | (v >> 4 & 4) | (v >> 6 & 8); }
+    static int index(int x, int y, int z) { return spread(x) | spread(y) << 1 | spread(z) << 2; }
+    static void coords(int i, int& x, int& y, int& z) {
+        x = compact(i);
+        y = compact(i >> 1);
+        z = compact(i >> 2);
+    }
+};
+static_assert(CHUNK_SIZE == 16, "LayoutMorton interleaves exactly four bits per axis");
+
+// Chosen at build time, e.g. -DCHUNK_LAYOUT=LayoutYZX. The linear orders measure
+// within noise of each other in LayoutBench (a chunk fits in L1); Morton is
+// slower for flood fills, so the original XYZ order stays the default.
+#ifndef CHUNK_LAYOUT
+#define CHUNK_LAYOUT LayoutXYZ
+#endif
+
+// Block ids of one chunk as a small local palette plus bit-packed indices into
+// it. The index width grows through 0, 1, 2, 4, 8 and 16 bits as the palette
+// fills, so a chunk of air and stone costs 512 bytes instead of 16 KiB.
+// A chunk holding a single block id (all sky, all stone) keeps just that id
+// and allocates nothing until the first write of a different block.
+// Idle storage can be compressed in place; any access decompresses it again.
+// Storage shared through a ChunkSnapshot is never compressed or modified, so
+// any number of threads may read it; otherwise one thread at a time.
+template <typename Layout>
+class BasicBlockStorage {
+public:
+    typedef Layout BlockLayout;
+
+    explicit BasicBlockStorage(int block = 0);
+    BasicBlockStorage(const BasicBlockStorage& other);
+    BasicBlockStorage(BasicBlockStorage&& other) noexcept;
+    BasicBlockStorage& operator=(const BasicBlockStorage& other);
+    BasicBlockStorage& operator=(BasicBlockStorage&& other) noexcept;
+
+    // Position of (x, y, z) in dense order, and back
+    static int index(int x, int y, int z) { return Layout::index(x, y, z); }
+    static void coords(int i, int& x, int& y, int& z) { Layout::coords(i, x, y, z); }
+
+    int get(int x, int y, int z) const {
+        if (bits == 0)
+            return uniform;
+        touch();
+        return palette[readIndex(index(x, y, z))];
+    }
+    void set(int x, int y, int z, int block);
+    void fill(int block);
+    // Like fill(), but keeps the buffers for the next pack() or read()
+    void reset(int block);
+
+    // Bulk conversion to and from CHUNK_VOLUME ids in dense order. pack() picks
+    // the smallest palette and width for the data.
+    void unpack(int* out) const;
+    void pack(const int* in);
+
+    // Appends the storage as bytes (width, palette, raw index words, host byte
+    // order) and reads it back. read() returns the bytes consumed, or 0 if the
+    // data is malformed, in which case the storage is left unchanged.
+    void write(std::vector<unsigned char>& out) const;
+    size_t read(const unsigned char* data, size_t size);
+
+    bool isUniform() const { return bits == 0; }
+    int uniformBlock() const { return uniform; }  // only meaningful when isUniform()
+
+    int paletteSize() const { return bits == 0 ? 1 : (int)palette.size(); }
+    int bitsPerBlock() const { return bits; }
+    size_t memoryUsage() const;
+
+    // Cold tier: LZ compresses the index words until the next access
+    void compress();
+    bool isCompressed() const { return !compressedWords.empty(); }
+    void decompress() const {
+        if (!compressedWords.empty())
+            inflate();
+    }
+
+    // True if the blocks were accessed since the last call. Otherwise, from
+    // the second call without an access on, they count as idle: the next
+    // access is a cold tier hit, or a miss if it has to decompress them.
+    bool takeReferenced();
+
+private:
+    int readIndex(int i) const {
+        int bit = i * bits;
+        return (int)((words[bit >> 6] >> (bit & 63)) & ((1ull << bits) - 1));
+    }
+    void writeIndex(int i, int paletteIndex);
+    void setBits(int newBits);
+    void inflate() const;
+    void touch() const {
+        if (!compressedWords.empty())
+            inflate();
+        else if (access.load(std::memory_order_relaxed) != ACCESS_USED)
+            markUsed();
+    }
+    void markUsed() const;
+
+    // What the cold tier sweep saw: used since its last pass, unused for one
+    // pass, or unused for a whole interval since (idle)
+    enum : uint8_t { ACCESS_USED, ACCESS_SWEPT, ACCESS_IDLE };
+
+    std::vector<int> palette;  // empty while uniform
+    mutable std::vector<uint64_t> words;
+    mutable std::vector<unsigned char> compressedWords;  // empty unless compressed
+    int bits = 0;
+    int uniform = 0;
+    mutable std::atomic<uint8_t> access{ACCESS_USED};  // snapshot readers set it concurrently
+};
+
+typedef BasicBlockStorage<CHUNK_LAYOUT> BlockStorage;
+
+// Process-wide cold tier counters, safe to read from any thread
+struct ColdStorageStats {
+    uint64_t compressions = 0;
+    uint64_t decompressions = 0;  // accesses that found the blocks compressed
+    uint64_t idleHits = 0;        // accesses to idle blocks that were still uncompressed
+    double decompressMicros = 0.0;  // total time spent decompressing
+
+    double averageDecompressMicros() const { return decompressions ? decompressMicros / decompressions : 0.0; }
+};
+ColdStorageStats coldStorageStats();
+
+// Read-only blocks of a chunk as they were at one version. Holding a snapshot
+// keeps that storage alive and unchanged; edits to the chunk go to a copy.
+struct ChunkSnapshot {
+    std::shared_ptr<const BlockStorage> blocks;
+    uint64_t version = 0;
+
+    explicit operator bool() const { return blocks != nullptr; }
+};
+
+// The blocks are copy-on-write: snapshot() shares the storage with worker
+// jobs, and the next edit copies it first if a snapshot is still alive. Every
+// change bumps version(), so a job can tell its result is stale by comparing
+// against the version of the snapshot it started from.
+struct Chunk {
+    bool dirty = true;    // mesh needs rebuilding
+    bool unsaved = true;  // changed since it was last written to disk
+
+    Chunk();
+    explicit Chunk(int block) : storage(std::make_shared<SharedBlocks>(block)) {}  // every block the same id
+    // Copies the blocks; snapshots stay with the original
+    Chunk(const Chunk& other);
+    Chunk& operator=(const Chunk& other);
+
+    const BlockStorage& blocks() const { return storage->blocks; }
+    // For in-place edits; unshares the storage and bumps the version
+    BlockStorage& editBlocks();
+    // Swaps in new contents (a load or a reset) without copying the old ones
+    void replaceBlocks(BlockStorage&& blocks);
+    void resetBlocks(int block);
+
+    uint64_t version() const { return blockVersion; }
+    bool isShared() const { return storage->readers.load(std::memory_order_acquire) > 0; }
+    ChunkSnapshot snapshot() const;
+    bool isCurrent(uint64_t snapshotVersion) const { return snapshotVersion == blockVersion; }
+
+    // Cold tier maintenance; shared storage is left alone
+    void compressBlocks() {
+        if (!isShared())
+            storage->blocks.compress();
+    }
+    bool takeReferenced() { return storage->blocks.takeReferenced(); }
+
+    int get(int x, int y, int z) const { return storage->blocks.get(x, y, z); }
+    void set(int x, int y, int z, int block) {
+        editBlocks().set(x, y, z, block);
+        dirty = true;
+        unsaved = true;
+    }
+
+private:
+    // The storage and the number of live snapshot() leases on it. A lease ends
+    // with a release decrement that isShared() acquires, so an edit in place
+    // always comes after the last reader is done with the blocks.
+    struct SharedBlocks {
+        BlockStorage blocks;
+        std::atomic<int> readers{ 0 };
+
+        SharedBlocks() {}
+        explicit SharedBlocks(int block) : blocks(block) {}
+        explicit SharedBlocks(const BlockStorage& other) : blocks(other) {}
+        explicit SharedBlocks(BlockStorage&& other) : blocks(std::move(other)) {}
+    };
+
+    std::shared_ptr<SharedBlocks> storage;
+    uint64_t blockVersion = 0;
+};
@@ -0,0 +1,37 @@
+#include <new>
+#include "chunk_pool.h"
+
+ChunkPool::ChunkPool(int chunksPerPage) : perPage(chunksPerPage) {
+}
+
+ChunkPool::~ChunkPool() {
+    for (int slot = 0; slot < used; ++slot)
+        at(slot).~Chunk();
+    for (Chunk* page : pages)
+        ::operator delete(page);
+}
+
+void ChunkPool::addPage() {
+    // Raw memory; chunks are constructed in it as slots are first handed out
+    pages.push_back((Chunk*)::operator new((size_t)perPage * sizeof(Chunk)));
+}
+
+int ChunkPool::allocate() {
+    if (!freeSlots.empty()) {
+        int slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+    if (used == (int)pages.size() * perPage)
+        addPage();
+    new (&at(used)) Chunk(0);
+    return used++;
+}
+
+void ChunkPool::release(int slot) {
+    Chunk& chunk = at(slot);
+    chunk.resetBlocks(0);
+    chunk.dirty = true;
+    chunk.unsaved = true;
+    freeSlots.push_back(slot);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "chunk.h"
+
+// === Chunk pool ===
+// Chunks live in fixed pages that never move, so a Chunk& (or a pointer handed
+// to a neighbour or worker thread) stays valid until its slot is released.
+// Released slots keep their block buffers and are handed out again first, so
+// streaming reuses memory instead of allocating per chunk.
+class ChunkPool {
+public:
+    explicit ChunkPool(int chunksPerPage = 1024);
+    ~ChunkPool();
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+
+    // Slot of an all-air chunk: the most recently released one if any
+    int allocate();
+    void release(int slot);
+
+    Chunk& at(int slot) { return pages[slot / perPage][slot % perPage]; }
+    const Chunk& at(int slot) const { return pages[slot / perPage][slot % perPage]; }
+
+    // Slots handed out so far, live or released
+    int capacity() const { return used; }
+
+private:
+    void addPage();
+
+    int perPage;
+    int used = 0;
+    std::vector<Chunk*> pages;
+    std::vector<int> freeSlots;
+};
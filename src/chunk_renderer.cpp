@@ -0,0 +1,137 @@
+#include <glad/glad.h>
+#include <cstdint>
+#include "chunk_renderer.h"
+
+void ChunkArena::init(int initialPages) {
+    // grow() creates the buffers themselves
+    glGenVertexArrays(1, &VAO);
+    glGenTextures(1, &originTexture);
+    pages = RangeAllocator();
+    grow(initialPages);
+}
+
+void ChunkArena::destroy() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    glDeleteBuffers(1, &originBuffer);
+    glDeleteTextures(1, &originTexture);
+    VAO = VBO = EBO = originBuffer = originTexture = 0;
+}
+
+void ChunkArena::bindVertexLayout() {
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+    // Define vertex layout: one packed uint per vertex, decoded in the shader
+    glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(ChunkVertex), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Reallocates the three buffers with room for newPages, keeping their contents
+void ChunkArena::grow(int newPages) {
+    int oldPages = pages.capacity();
+    struct Resize {
+        unsigned int* buffer;
+        GLsizeiptr pageBytes;
+    } resizes[] = {
+        { &VBO, PAGE_VERTICES * sizeof(ChunkVertex) },
+        { &EBO, PAGE_INDICES * sizeof(unsigned int) },
+        { &originBuffer, 4 * sizeof(float) },
+    };
+
+    for (Resize& r : resizes) {
+        unsigned int bigger;
+        glGenBuffers(1, &bigger);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, bigger);
+        glBufferData(GL_COPY_WRITE_BUFFER, newPages * r.pageBytes, nullptr, GL_DYNAMIC_DRAW);
+        if (oldPages > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, *r.buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldPages * r.pageBytes);
+        }
+        glDeleteBuffers(1, r.buffer);
+        *r.buffer = bigger;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    bindVertexLayout();
+    glBindTexture(GL_TEXTURE_BUFFER, originTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, originBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    pages.grow(newPages);
+}
+
+void ChunkArena::upload(ChunkArenaSlot& slot, const ChunkMesh& mesh, const glm::vec3& chunkOrigin) {
+    release(slot);
+    if (mesh.indices.empty())
+        return;
+
+    int vertexPages = ((int)mesh.vertices.size() + PAGE_VERTICES - 1) / PAGE_VERTICES;
+    int indexPages = ((int)mesh.indices.size() + PAGE_INDICES - 1) / PAGE_INDICES;
+    int count = vertexPages > indexPages ? vertexPages : indexPages;
+
+    int first = pages.allocate(count);
+    while (first < 0) {
+        grow(pages.capacity() * 2 + count);
+        first = pages.allocate(count);
+    }
+    slot.firstPage = first;
+    slot.pageCount = count;
+    slot.indexCount = (int)mesh.indices.size();
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)first * PAGE_VERTICES * sizeof(ChunkVertex),
+        mesh.vertices.size() * sizeof(ChunkVertex), mesh.vertices.data());
+
+    // Indices stay relative to the chunk's first vertex; the draw adds the base vertex
+    glBindBuffer(GL_ARRAY_BUFFER, EBO);
+    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)first * PAGE_INDICES * sizeof(unsigned int),
+        mesh.indices.size() * sizeof(unsigned int), mesh.indices.data());
+
+    std::vector<float> origins(count * 4);
+    for (int i = 0; i < count; ++i) {
+        origins[i * 4 + 0] = chunkOrigin.x;
+        origins[i * 4 + 1] = chunkOrigin.y;
+        origins[i * 4 + 2] = chunkOrigin.z;
+        origins[i * 4 + 3] = 0.0f;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, originBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)first * 4 * sizeof(float), origins.size() * sizeof(float), origins.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ChunkArena::release(ChunkArenaSlot& slot) {
+    if (slot.pageCount > 0)
+        pages.release(slot.firstPage, slot.pageCount);
+    slot = ChunkArenaSlot();
+}
+
+void ChunkArena::addDraw(const ChunkArenaSlot& slot) {
+    if (slot.indexCount == 0)
+        return;
+    drawCounts.push_back(slot.indexCount);
+    drawOffsets.push_back((void*)((uintptr_t)slot.firstPage * PAGE_INDICES * sizeof(unsigned int)));
+    drawBaseVertices.push_back(slot.firstPage * PAGE_VERTICES);
+}
+
+void ChunkArena::flushDraws() {
+    if (!drawCounts.empty()) {
+        glActiveTexture(GL_TEXTURE0 + ORIGIN_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, originTexture);
+        glActiveTexture(GL_TEXTURE0);
+
+        glBindVertexArray(VAO);
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, drawCounts.data(), GL_UNSIGNED_INT,
+            drawOffsets.data(), (GLsizei)drawCounts.size(), drawBaseVertices.data());
+        glBindVertexArray(0);
+    }
+    drawCounts.clear();
+    drawOffsets.clear();
+    drawBaseVertices.clear();
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "mesher.h"
+#include "range_allocator.h"
+
+// Chunk meshes are sub-allocated in pages; a page holds PAGE_VERTICES vertices
+// and the PAGE_INDICES indices that quads over them need
+const int PAGE_VERTICES = 256;
+const int PAGE_INDICES = PAGE_VERTICES / 4 * 6;
+
+// Where one chunk's mesh lives inside the arena
+struct ChunkArenaSlot {
+    int firstPage = -1;
+    int pageCount = 0;
+    int indexCount = 0;
+};
+
+// All chunk meshes share one VAO, vertex buffer and index buffer. Each page's
+// chunk origin sits in a buffer texture the vertex shader reads with
+// gl_VertexID / PAGE_VERTICES, so every visible chunk goes out in a single
+// glMultiDrawElementsBaseVertex call with no per-chunk binds or uniforms.
+class ChunkArena {
+public:
+    void init(int initialPages);
+    void destroy();
+
+    // Replaces whatever the slot held with the new mesh
+    void upload(ChunkArenaSlot& slot, const ChunkMesh& mesh, const glm::vec3& chunkOrigin);
+    void release(ChunkArenaSlot& slot);
+
+    // Queue a chunk for this frame's multi-draw, then submit them all at once
+    void addDraw(const ChunkArenaSlot& slot);
+    void flushDraws();
+
+    // Texture unit the chunk-origin buffer texture is bound to while drawing
+    static const int ORIGIN_TEXTURE_UNIT = 1;
+
+private:
+    void grow(int newPages);
+    void bindVertexLayout();
+
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    unsigned int originBuffer = 0, originTexture = 0;
+    RangeAllocator pages;
+
+    std::vector<int> drawCounts;
+    std::vector<void*> drawOffsets;
+    std::vector<int> drawBaseVertices;
+};
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "compress.h"
+
+const int LZ_MIN_MATCH = 4;
+const int LZ_HASH_BITS = 12;
+const size_t LZ_MAX_OFFSET = 65535;
+
+static uint32_t read32(const unsigned char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, 4);
+    return value;
+}
+
+// Lengths of 15 and up spill into extra bytes of 255 until one is smaller
+static void writeLength(std::vector<unsigned char>& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back((unsigned char)length);
+}
+
+static bool readLength(const unsigned char*& src, const unsigned char* end, size_t& length) {
+    unsigned char byte;
+    do {
+        if (src == end)
+            return false;
+        byte = *src++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+static void writeSequence(std::vector<unsigned char>& out, const unsigned char* literals, size_t literalCount,
+                          size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength ? matchLength - LZ_MIN_MATCH : 0;
+    out.push_back((unsigned char)((literalCount < 15 ? literalCount : 15) << 4 | (matchCode < 15 ? matchCode : 15)));
+    if (literalCount >= 15)
+        writeLength(out, literalCount - 15);
+    out.insert(out.end(), literals, literals + literalCount);
+    if (matchLength == 0)
+        return;  // last sequence: literals only
+    out.push_back((unsigned char)(offset & 0xff));
+    out.push_back((unsigned char)(offset >> 8));
+    if (matchCode >= 15)
+        writeLength(out, matchCode - 15);
+}
+
+size_t lzCompress(const unsigned char* src, size_t size, std::vector<unsigned char>& out) {
+    size_t start = out.size();
+    int32_t table[1 << LZ_HASH_BITS];
+    std::memset(table, 0xff, sizeof(table));
+
+    size_t anchor = 0, pos = 0;
+    while (pos + LZ_MIN_MATCH <= size) {
+        uint32_t sequence = read32(src + pos);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+        int32_t candidate = table[hash];
+        table[hash] = (int32_t)pos;
+
+        if (candidate < 0 || pos - candidate > LZ_MAX_OFFSET || read32(src + candidate) != sequence) {
+            ++pos;
+            continue;
+        }
+        size_t length = LZ_MIN_MATCH;
+        while (pos + length < size && src[candidate + length] == src[pos + length])
+            ++length;
+        writeSequence(out, src + anchor, pos - anchor, pos - candidate, length);
+        pos += length;
+        anchor = pos;
+    }
+    writeSequence(out, src + anchor, size - anchor, 0, 0);
+    return out.size() - start;
+}
+
+// Decodes until dstSize bytes are out. With exact the input must end right
+// there; otherwise decoding stops early, partway through a sequence if need be.
+static bool lzDecode(const unsigned char* src, size_t size, unsigned char* dst, size_t dstSize, bool exact) {
+    const unsigned char* end = src + size;
+    size_t written = 0;
+    while (src < end) {
+        unsigned char token = *src++;
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(src, end, literalCount))
+            return false;
+        if (literalCount > (size_t)(end - src) || (exact && literalCount > dstSize - written))
+            return false;
+        size_t copied = std::min(literalCount, dstSize - written);
+        std::memcpy(dst + written, src, copied);
+        src += literalCount;
+        written += copied;
+        if (!exact && written == dstSize)
+            return true;
+        if (src == end)
+            break;
+
+        if (end - src < 2)
+            return false;
+        size_t offset = src[0] | (size_t)src[1] << 8;
+        src += 2;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(src, end, length))
+            return false;
+        length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > written || (exact && length > dstSize - written))
+            return false;
+        length = std::min(length, dstSize - written);
+
+        // Byte by byte: a match may overlap the bytes it is producing
+        const unsigned char* from = dst + written - offset;
+        for (size_t i = 0; i < length; ++i)
+            dst[written + i] = from[i];
+        written += length;
+        if (!exact && written == dstSize)
+            return true;
+    }
+    return written == dstSize;
+}
+
+bool lzDecompress(const unsigned char* src, size_t size, unsigned char* dst, size_t dstSize) {
+    return lzDecode(src, size, dst, dstSize, true);
+}
+
+bool lzDecompressPrefix(const unsigned char* src, size_t size, unsigned char* dst, size_t count) {
+    return lzDecode(src, size, dst, count, false);
+}
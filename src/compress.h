@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// === Byte compression ===
+// LZ77 in the LZ4 block layout: each sequence is a token (literal length,
+// match length), the literals, then a 16-bit back offset. Matches are found
+// through a single hash table of 4-byte prefixes, so compression runs close to
+// memory speed and decompression is a plain copy loop.
+
+// Appends the compressed form of src to out and returns its size
+size_t lzCompress(const unsigned char* src, size_t size, std::vector<unsigned char>& out);
+
+// Decodes exactly dstSize bytes; false if the input is malformed or the wrong size
+bool lzDecompress(const unsigned char* src, size_t size, unsigned char* dst, size_t dstSize);
+// Decodes only the first count bytes, e.g. a header; false if the input breaks before them
+bool lzDecompressPrefix(const unsigned char* src, size_t size, unsigned char* dst, size_t count);
@@ -0,0 +1,85 @@
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_SSE 1
+#include <emmintrin.h>
+#endif
+#include "frustum.h"
+
+Frustum extractFrustum(const glm::mat4& viewProjection) {
+    // glm is column-major: row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    const glm::mat4& m = viewProjection;
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum frustum;
+    frustum.planes[0] = row3 + row0;  // left
+    frustum.planes[1] = row3 - row0;  // right
+    frustum.planes[2] = row3 + row1;  // bottom
+    frustum.planes[3] = row3 - row1;  // top
+    frustum.planes[4] = row3 + row2;  // near
+    frustum.planes[5] = row3 - row2;  // far
+    return frustum;
+}
+
+void BoundsList::clear() {
+    minX.clear(); minY.clear(); minZ.clear();
+    maxX.clear(); maxY.clear(); maxZ.clear();
+}
+
+void BoundsList::add(const glm::vec3& min, const glm::vec3& max) {
+    minX.push_back(min.x); minY.push_back(min.y); minZ.push_back(min.z);
+    maxX.push_back(max.x); maxY.push_back(max.y); maxZ.push_back(max.z);
+}
+
+void BoundsList::set(size_t index, const glm::vec3& min, const glm::vec3& max) {
+    minX[index] = min.x; minY[index] = min.y; minZ[index] = min.z;
+    maxX[index] = max.x; maxY[index] = max.y; maxZ[index] = max.z;
+}
+
+// A box is outside when its corner furthest along the plane normal is still behind it
+static bool boxVisible(const Frustum& frustum, const BoundsList& b, size_t i) {
+    for (const glm::vec4& p : frustum.planes) {
+        float x = p.x >= 0.0f ? b.maxX[i] : b.minX[i];
+        float y = p.y >= 0.0f ? b.maxY[i] : b.minY[i];
+        float z = p.z >= 0.0f ? b.maxZ[i] : b.minZ[i];
+        if (p.x * x + p.y * y + p.z * z + p.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+int cullBounds(const Frustum& frustum, const BoundsList& bounds, std::vector<unsigned char>& visible) {
+    size_t count = bounds.size();
+    visible.resize(count);
+    int visibleCount = 0;
+    size_t i = 0;
+
+#ifdef FRUSTUM_SSE
+    // Four boxes per iteration; the plane's signs pick min or max for all four lanes
+    for (; i + 4 <= count; i += 4) {
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const glm::vec4& p : frustum.planes) {
+            __m128 x = _mm_loadu_ps(p.x >= 0.0f ? &bounds.maxX[i] : &bounds.minX[i]);
+            __m128 y = _mm_loadu_ps(p.y >= 0.0f ? &bounds.maxY[i] : &bounds.minY[i]);
+            __m128 z = _mm_loadu_ps(p.z >= 0.0f ? &bounds.maxZ[i] : &bounds.minZ[i]);
+            __m128 d = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(p.x)), _mm_mul_ps(y, _mm_set1_ps(p.y))),
+                _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(p.z)), _mm_set1_ps(p.w)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, _mm_setzero_ps()));
+        }
+        int mask = _mm_movemask_ps(inside);
+        for (int lane = 0; lane < 4; ++lane) {
+            unsigned char v = (mask >> lane) & 1;
+            visible[i + lane] = v;
+            visibleCount += v;
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        visible[i] = boxVisible(frustum, bounds, i) ? 1 : 0;
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+// Six planes (left, right, bottom, top, near, far) as ax + by + cz + d,
+// with positive values on the inside
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+// Gribb/Hartmann extraction from a projection * view matrix
+Frustum extractFrustum(const glm::mat4& viewProjection);
+
+// Axis-aligned boxes in structure-of-arrays form so four can be tested per SSE op
+struct BoundsList {
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    size_t size() const { return minX.size(); }
+    void clear();
+    void add(const glm::vec3& min, const glm::vec3& max);
+    void set(size_t index, const glm::vec3& min, const glm::vec3& max);
+};
+
+// visible[i] becomes 1 for boxes at least partly inside the frustum;
+// returns how many are visible. Conservative: boxes straddling a frustum
+// corner can be reported visible.
+int cullBounds(const Frustum& frustum, const BoundsList& bounds, std::vector<unsigned char>& visible);
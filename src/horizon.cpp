@@ -0,0 +1,189 @@
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/type_ptr.hpp>
+#include "horizon.h"
+#include "terrain.h"
+
+static const char* horizonVertexSource = "#version 330 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "layout (location = 1) in float aShade;\n"
+    "out vec3 WorldPos;\n"
+    "out float Shade;\n"
+    "uniform mat4 viewProjection;\n"
+    "void main() {\n"
+    "   gl_Position = viewProjection * vec4(aPos, 1.0);\n"
+    "   WorldPos = aPos;\n"
+    "   Shade = aShade;\n"
+    "}\0";
+
+static const char* horizonFragmentSource = "#version 330 core\n"
+    "out vec4 FragColor;\n"
+    "in vec3 WorldPos;\n"
+    "in float Shade;\n"
+    "uniform vec4 voxelArea;\n"
+    "uniform vec3 cameraPos;\n"
+    "uniform vec3 fogColor;\n"
+    "uniform float fogEnd;\n"
+    "void main() {\n"
+    "   if (WorldPos.x > voxelArea.x && WorldPos.z > voxelArea.y && WorldPos.x < voxelArea.z && WorldPos.z < voxelArea.w)\n"
+    "       discard;\n"
+    "   vec3 grass = vec3(0.36, 0.60, 0.25) * Shade;\n"
+    "   float fog = smoothstep(fogEnd * 0.3, fogEnd, length(WorldPos.xz - cameraPos.xz));\n"
+    "   FragColor = vec4(mix(grass, fogColor, fog), 1.0);\n"
+    "}\n";
+
+void buildHorizonTile(int tileX, int tileZ, std::vector<float>& vertices) {
+    const int N = HORIZON_TILE_CELLS + 1;
+    int originX = tileX * HORIZON_TILE_BLOCKS;
+    int originZ = tileZ * HORIZON_TILE_BLOCKS;
+
+    // Surface heights of the tile's grid plus a one-cell rim for the slopes, in one batch
+    const int G = N + 2;
+    std::vector<int> heights(G * G);
+    getSurfaceHeights(originX - HORIZON_CELL_BLOCKS, originZ - HORIZON_CELL_BLOCKS, HORIZON_CELL_BLOCKS, G, G,
+                      heights.data());
+    auto height = [&](int i, int j) { return heights[(i + 1) * G + (j + 1)]; };
+
+    vertices.clear();
+    for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < N; ++j) {
+            int x = originX + i * HORIZON_CELL_BLOCKS;
+            int z = originZ + j * HORIZON_CELL_BLOCKS;
+            // A block below the top face of the voxel surface (at height + 0.5), so the seam never pokes through
+            float y = (float)height(i, j);
+
+            // Slope shading from the surface gradient
+            float dx = (float)(height(i + 1, j) - height(i - 1, j));
+            float dz = (float)(height(i, j + 1) - height(i, j - 1));
+            glm::vec3 normal = glm::normalize(glm::vec3(-dx, 2.0f * HORIZON_CELL_BLOCKS, -dz));
+            float shade = 0.55f + 0.45f * glm::dot(normal, glm::normalize(glm::vec3(0.4f, 1.0f, 0.3f)));
+
+            vertices.push_back(x - 0.5f);
+            vertices.push_back(y - 0.5f);
+            vertices.push_back(z - 0.5f);
+            vertices.push_back(shade);
+        }
+    }
+}
+
+void HorizonRenderer::init() {
+    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &horizonVertexSource, nullptr);
+    glCompileShader(vertexShader);
+
+    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &horizonFragmentSource, nullptr);
+    glCompileShader(fragmentShader);
+
+    shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    // Two triangles per grid cell
+    const int N = HORIZON_TILE_CELLS + 1;
+    std::vector<unsigned int> indices;
+    for (int i = 0; i < HORIZON_TILE_CELLS; ++i) {
+        for (int j = 0; j < HORIZON_TILE_CELLS; ++j) {
+            unsigned int a = i * N + j, b = (i + 1) * N + j;
+            unsigned int quad[6] = { a, b, b + 1, b + 1, a + 1, a };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+    indexCount = (int)indices.size();
+
+    glGenBuffers(1, &EBO);
+    glBindBuffer(GL_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void HorizonRenderer::destroy() {
+    for (Tile& tile : tiles) {
+        glDeleteVertexArrays(1, &tile.VAO);
+        glDeleteBuffers(1, &tile.VBO);
+    }
+    tiles.clear();
+    glDeleteBuffers(1, &EBO);
+    glDeleteProgram(shaderProgram);
+    EBO = shaderProgram = 0;
+}
+
+void HorizonRenderer::update(const glm::vec3& cameraPos, int maxNewTiles) {
+    int cameraTileX = (int)std::floor(cameraPos.x / HORIZON_TILE_BLOCKS);
+    int cameraTileZ = (int)std::floor(cameraPos.z / HORIZON_TILE_BLOCKS);
+
+    // Drop tiles that left the ring
+    for (size_t i = 0; i < tiles.size(); ) {
+        if (std::abs(tiles[i].x - cameraTileX) > HORIZON_RADIUS_TILES ||
+            std::abs(tiles[i].z - cameraTileZ) > HORIZON_RADIUS_TILES) {
+            glDeleteVertexArrays(1, &tiles[i].VAO);
+            glDeleteBuffers(1, &tiles[i].VBO);
+            tiles[i] = tiles.back();
+            tiles.pop_back();
+        }
+        else {
+            ++i;
+        }
+    }
+
+    // Missing tiles in the ring, nearest first
+    std::vector<glm::ivec2> missing;
+    for (int x = cameraTileX - HORIZON_RADIUS_TILES; x <= cameraTileX + HORIZON_RADIUS_TILES; ++x) {
+        for (int z = cameraTileZ - HORIZON_RADIUS_TILES; z <= cameraTileZ + HORIZON_RADIUS_TILES; ++z) {
+            bool loaded = false;
+            for (const Tile& tile : tiles)
+                loaded = loaded || (tile.x == x && tile.z == z);
+            if (!loaded)
+                missing.emplace_back(x, z);
+        }
+    }
+    std::sort(missing.begin(), missing.end(), [&](const glm::ivec2& a, const glm::ivec2& b) {
+        int da = (a.x - cameraTileX) * (a.x - cameraTileX) + (a.y - cameraTileZ) * (a.y - cameraTileZ);
+        int db = (b.x - cameraTileX) * (b.x - cameraTileX) + (b.y - cameraTileZ) * (b.y - cameraTileZ);
+        return da < db;
+    });
+
+    for (size_t i = 0; i < missing.size() && (int)i < maxNewTiles; ++i) {
+        Tile tile;
+        tile.x = missing[i].x;
+        tile.z = missing[i].y;
+        buildHorizonTile(tile.x, tile.z, scratch);
+
+        glGenVertexArrays(1, &tile.VAO);
+        glGenBuffers(1, &tile.VBO);
+        glBindVertexArray(tile.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, tile.VBO);
+        glBufferData(GL_ARRAY_BUFFER, scratch.size() * sizeof(float), scratch.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        tiles.push_back(tile);
+    }
+}
+
+void HorizonRenderer::draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos,
+                           const glm::vec4& voxelArea, const glm::vec3& fogColor) {
+    glUseProgram(shaderProgram);
+    glm::mat4 viewProjection = projection * view;
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "viewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+    glUniform4fv(glGetUniformLocation(shaderProgram, "voxelArea"), 1, glm::value_ptr(voxelArea));
+    glUniform3fv(glGetUniformLocation(shaderProgram, "cameraPos"), 1, glm::value_ptr(cameraPos));
+    glUniform3fv(glGetUniformLocation(shaderProgram, "fogColor"), 1, glm::value_ptr(fogColor));
+    glUniform1f(glGetUniformLocation(shaderProgram, "fogEnd"), (float)(HORIZON_RADIUS_TILES * HORIZON_TILE_BLOCKS));
+
+    for (const Tile& tile : tiles) {
+        glBindVertexArray(tile.VAO);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    }
+    glBindVertexArray(0);
+}
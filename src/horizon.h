@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+// === Far-field horizon ===
+// Beyond the voxel chunks the world is drawn as a coarse heightmap grid built
+// straight from getSurfaceHeights, so the horizon is filled without any Chunk
+// data and meets the voxel terrain of whichever generator is active.
+const int HORIZON_TILE_BLOCKS = 128;  // tile edge in blocks
+const int HORIZON_CELL_BLOCKS = 4;    // grid spacing inside a tile
+const int HORIZON_RADIUS_TILES = 6;   // tiles kept around the camera tile
+const float HORIZON_FAR_PLANE = 2000.0f;
+
+const int HORIZON_TILE_CELLS = HORIZON_TILE_BLOCKS / HORIZON_CELL_BLOCKS;
+const int HORIZON_TILE_VERTICES = (HORIZON_TILE_CELLS + 1) * (HORIZON_TILE_CELLS + 1);
+
+// Position + shade for every grid vertex of tile (tileX, tileZ), row-major in x
+void buildHorizonTile(int tileX, int tileZ, std::vector<float>& vertices);
+
+class HorizonRenderer {
+public:
+    void init();
+    void destroy();
+
+    // Drops tiles that fell out of range and builds at most maxNewTiles missing
+    // ones, nearest first, so moving the camera never stalls a frame
+    void update(const glm::vec3& cameraPos, int maxNewTiles);
+
+    // voxelArea is (minX, minZ, maxX, maxZ) of the loaded chunks; the horizon
+    // is discarded there so the real terrain always wins
+    void draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos,
+              const glm::vec4& voxelArea, const glm::vec3& fogColor);
+
+private:
+    struct Tile {
+        int x, z;
+        unsigned int VAO, VBO;
+    };
+
+    std::vector<Tile> tiles;
+    std::vector<float> scratch;
+    unsigned int EBO = 0;  // the grid topology is shared by every tile
+    int indexCount = 0;
+    unsigned int shaderProgram = 0;
+};
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <chrono>
+#include "jobs.h"
+
+struct JobSystem::Job {
+    Function function;
+    std::atomic<int> waiting{ 1 };  // unfinished dependencies, plus one until submit() is done
+    std::mutex lock;                // guards dependents against a dependency finishing
+    std::atomic<bool> finished{ false };
+    std::vector<std::shared_ptr<Job>> dependents;
+};
+
+// Lets a job that submits more work push it onto its own worker's deque
+static thread_local const JobSystem* currentSystem = nullptr;
+static thread_local int currentWorker = -1;
+
+bool JobSystem::Handle::done() const {
+    return !job || job->finished.load(std::memory_order_acquire);
+}
+
+int JobSystem::defaultWorkerCount() {
+    int cores = (int)std::thread::hardware_concurrency();
+    return std::max(1, cores - 1);
+}
+
+JobSystem::JobSystem(int workerCount) {
+    workerCount = std::max(1, workerCount);
+    for (int i = 0; i < workerCount; ++i)
+        queues.emplace_back(new WorkerQueue());
+    for (int i = 0; i < workerCount; ++i)
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+    waitIdle();
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+JobSystem::Handle JobSystem::submit(Function function) {
+    return submit(std::move(function), std::vector<Handle>());
+}
+
+JobSystem::Handle JobSystem::submit(Function function, const std::vector<Handle>& dependencies) {
+    Handle handle;
+    handle.job = std::make_shared<Job>();
+    Job& job = *handle.job;
+    job.function = std::move(function);
+    outstanding.fetch_add(1);
+
+    for (const Handle& dependency : dependencies) {
+        if (!dependency.job)
+            continue;
+        std::lock_guard<std::mutex> guard(dependency.job->lock);
+        if (!dependency.job->finished.load(std::memory_order_relaxed)) {
+            dependency.job->dependents.push_back(handle.job);
+            job.waiting.fetch_add(1);
+        }
+    }
+    if (job.waiting.fetch_sub(1) == 1)
+        enqueue(handle.job);
+    return handle;
+}
+
+void JobSystem::enqueue(const std::shared_ptr<Job>& job) {
+    int worker = currentSystem == this ? currentWorker : (int)(nextQueue.fetch_add(1) % queues.size());
+    {
+        std::lock_guard<std::mutex> guard(queues[worker]->lock);
+        queues[worker]->jobs.push_back(job);
+    }
+    queued.fetch_add(1);
+
+    // A worker counts itself in sleepers before it checks queued, so one of the two sees the other
+    if (sleepers.load() > 0) {
+        { std::lock_guard<std::mutex> guard(sleepLock); }
+        wake.notify_one();
+    }
+}
+
+// Own deque from the back, then the others from the front. worker is -1 for
+// threads outside the pool, which can only steal.
+std::shared_ptr<JobSystem::Job> JobSystem::findJob(int worker) {
+    if (queued.load() == 0)
+        return nullptr;
+
+    std::shared_ptr<Job> job;
+    if (worker >= 0) {
+        WorkerQueue& own = *queues[worker];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+        }
+    }
+    int count = (int)queues.size();
+    int start = worker >= 0 ? worker + 1 : (int)(nextQueue.load(std::memory_order_relaxed) % count);
+    for (int k = 0; k < count && !job; ++k) {
+        int victim = (start + k) % count;
+        if (victim == worker)
+            continue;
+        WorkerQueue& other = *queues[victim];
+        std::lock_guard<std::mutex> guard(other.lock);
+        if (!other.jobs.empty()) {
+            job = std::move(other.jobs.front());
+            other.jobs.pop_front();
+            if (worker >= 0)
+                stolen.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (job)
+        queued.fetch_sub(1);
+    return job;
+}
+
+void JobSystem::run(const std::shared_ptr<Job>& job) {
+    job->function();
+    job->function = nullptr;  // drops whatever the job captured
+
+    std::vector<std::shared_ptr<Job>> ready;
+    {
+        std::lock_guard<std::mutex> guard(job->lock);
+        job->finished.store(true, std::memory_order_release);
+        ready.swap(job->dependents);
+    }
+    for (const std::shared_ptr<Job>& dependent : ready)
+        if (dependent->waiting.fetch_sub(1) == 1)
+            enqueue(dependent);
+
+    executed.fetch_add(1, std::memory_order_relaxed);
+    if (outstanding.fetch_sub(1) == 1) {
+        { std::lock_guard<std::mutex> guard(sleepLock); }
+        wake.notify_all();
+    }
+}
+
+// One step of waiting: runs a job if there is one, otherwise naps briefly.
+// Returns false once the pool is shutting down with nothing left to run.
+bool JobSystem::helpOrSleep(int worker) {
+    std::shared_ptr<Job> job = findJob(worker);
+    if (job) {
+        run(job);
+        return true;
+    }
+    std::unique_lock<std::mutex> guard(sleepLock);
+    if (worker < 0) {
+        // Waiters are not counted as sleepers; completions are polled
+        wake.wait_for(guard, std::chrono::milliseconds(1), [this] { return queued.load() > 0 || outstanding.load() == 0; });
+        return true;
+    }
+    sleepers.fetch_add(1);
+    wake.wait(guard, [this] { return stopping || queued.load() > 0; });
+    sleepers.fetch_sub(1);
+    return !(stopping && queued.load() == 0);
+}
+
+void JobSystem::workerLoop(int worker) {
+    currentSystem = this;
+    currentWorker = worker;
+    while (helpOrSleep(worker)) {
+    }
+}
+
+void JobSystem::wait(const Handle& handle) {
+    int worker = currentSystem == this ? currentWorker : -1;
+    while (!handle.done()) {
+        std::shared_ptr<Job> job = findJob(worker);
+        if (job) {
+            run(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wake.wait_for(guard, std::chrono::milliseconds(1), [this, &handle] { return handle.done() || queued.load() > 0; });
+    }
+}
+
+void JobSystem::waitIdle() {
+    while (outstanding.load() > 0)
+        helpOrSleep(-1);
+}
+
+JobStats JobSystem::stats() const {
+    JobStats result;
+    result.executed = executed.load(std::memory_order_relaxed);
+    result.stolen = stolen.load(std::memory_order_relaxed);
+    return result;
+}
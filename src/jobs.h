@@ -0,0 +1,136 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct JobStats {
+    uint64_t executed = 0;  // jobs run, on workers or by threads waiting in wait()
+    uint64_t stolen = 0;    // of those, taken from another worker's deque
+};
+
+// === Job system ===
+// A fixed set of worker threads, each with its own deque of ready jobs. A
+// worker pushes and pops the back of its own deque (newest first, still warm
+// in cache) and, when that runs dry, steals the oldest job from the front of
+// another worker's. Jobs submitted from other threads are dealt round-robin.
+// A job may depend on others; it only becomes ready once all of them finished.
+// Each deque has its own short lock, so workers only contend while stealing.
+class JobSystem {
+public:
+    typedef std::function<void()> Function;
+
+    struct Job;
+    class Handle {
+    public:
+        Handle() {}
+        bool done() const;
+        explicit operator bool() const { return job != nullptr; }
+
+    private:
+        friend class JobSystem;
+        std::shared_ptr<Job> job;
+    };
+
+    // One worker per core, less the one the render thread keeps busy
+    static int defaultWorkerCount();
+
+    explicit JobSystem(int workerCount = defaultWorkerCount());
+    ~JobSystem();  // runs everything already submitted, then joins the workers
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    Handle submit(Function function);
+    Handle submit(Function function, const std::vector<Handle>& dependencies);
+
+    // Both run queued jobs on the calling thread while they wait
+    void wait(const Handle& handle);
+    void waitIdle();
+
+    int workerCount() const { return (int)workers.size(); }
+    JobStats stats() const;
+
+private:
+    struct WorkerQueue {
+        std::mutex lock;
+        std::deque<std::shared_ptr<Job>> jobs;
+    };
+
+    void enqueue(const std::shared_ptr<Job>& job);
+    std::shared_ptr<Job> findJob(int worker);
+    void run(const std::shared_ptr<Job>& job);
+    bool helpOrSleep(int worker);
+    void workerLoop(int worker);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<unsigned> nextQueue{0};
+    std::atomic<int> queued{0};       // ready jobs sitting in a deque
+    std::atomic<int> outstanding{0};  // submitted and not finished yet
+
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::atomic<int> sleepers{0};
+    bool stopping = false;
+
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> stolen{0};
+};
+
+// Results on their way from worker jobs to one consumer thread, usually the
+// main thread. push() never blocks: it links a node onto the list head with a
+// compare-exchange. drain() detaches the whole list with a single exchange
+// and returns it oldest first, so there is no ABA hazard.
+template <typename T>
+class CompletionQueue {
+public:
+    CompletionQueue() {}
+    ~CompletionQueue() {
+        std::vector<T> rest;
+        drain(rest);
+    }
+    CompletionQueue(const CompletionQueue&) = delete;
+    CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+    // From any thread
+    void push(T value) {
+        Node* node = new Node{ std::move(value), head.load(std::memory_order_relaxed) };
+        while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    // From the consumer thread only; appends to out and returns the count
+    size_t drain(std::vector<T>& out) {
+        Node* list = head.exchange(nullptr, std::memory_order_acquire);
+        Node* oldestFirst = nullptr;
+        while (list) {
+            Node* next = list->next;
+            list->next = oldestFirst;
+            oldestFirst = list;
+            list = next;
+        }
+        size_t count = 0;
+        while (oldestFirst) {
+            Node* next = oldestFirst->next;
+            out.push_back(std::move(oldestFirst->value));
+            delete oldestFirst;
+            oldestFirst = next;
+            ++count;
+        }
+        return count;
+    }
+
+    bool empty() const { return head.load(std::memory_order_relaxed) == nullptr; }
+
+private:
+    struct Node {
+        T value;
+        Node* next;
+    };
+    std::atomic<Node*> head{ nullptr };
+};
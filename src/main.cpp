@@ -1,41 +1,37 @@
 ﻿#include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <algorithm>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image/stb_image.h>
 #include <filesystem>
 #include <fstream>
+#include <string>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#define TILE_SIZE (1.0f / 6.0f)
-#define TILE_U(col) ((col) * TILE_SIZE)
-#define TILE_V(row) ((row) * TILE_SIZE)
+#include "chunk.h"
+#include "world.h"
+#include "terrain.h"
+#include "mesher.h"
+#include "chunk_renderer.h"
+#include "frustum.h"
+#include "visibility.h"
+#include "horizon.h"
+#include "autosave.h"
+#include "jobs.h"
+#include "streaming.h"
 // === Global Camera Variables ===
 float playerYVelocity = 0.0f;
 const float gravity = -9.8f;
 const float jumpStrength = 5.0f;
 bool isGrounded = false;
 
-const int CHUNK_SIZE = 16;
-
-struct Chunk {
-    int blocks[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE];
-
-    Chunk() {
-        for (int x = 0; x < CHUNK_SIZE; ++x)
-            for (int y = 0; y < CHUNK_SIZE; ++y)
-                for (int z = 0; z < CHUNK_SIZE; ++z)
-                    blocks[x][y][z] = (y < CHUNK_SIZE / 2) ? 1 : 0;  // simple terrain
-    }
-};
-
-glm::vec3 cameraPos = glm::vec3(0.0f, 8.0f, 3.0f); // 1 block above terrain
+glm::vec3 cameraPos = glm::vec3(0.0f, 8.0f, 3.0f); // y is set on the terrain at start-up
 
 glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
 glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
 glm::ivec3 blockPos = glm::floor(cameraPos);
-std::vector<glm::vec3> chunkPositions;
 
 
 float yaw = -90.0f;  // Start facing negative Z
@@ -43,20 +39,33 @@ float pitch = 0.0f;
 float lastX = 800.0f / 2.0;  // Assuming 800x600 window
 float lastY = 600.0f / 2.0;
 bool firstMouse = true;
-int getHeight(int x, int z) {
-    return (int)(5.0f * sin(0.1f * x) * cos(0.1f * z)) + 8;  // wavy hills
+
+// Mesher used when a chunk is rebaked; MESH_CULLED skips face merging
+MeshMode chunkMeshMode = MESH_GREEDY;
+// Debug: print the triangle count of every uploaded mesh. The window title
+// always shows the meshes uploaded per second and their average size.
+bool logMeshedChunks = false;
+
+// Seconds between background saves of changed chunks
+const float AUTOSAVE_INTERVAL = 30.0f;
+
+void printSaveStats(const SaveStats& stats) {
+    std::cout << "Saved " << stats.chunksSaved << " chunks (" << stats.columnsSaved << " columns): "
+              << (int)stats.chunksPerSecond() << " chunks/s, " << stats.megabytesPerSecond() << " MB/s, "
+              << stats.encodedBytes / 1024 << " -> " << stats.writtenBytes / 1024 << " KiB, "
+              << stats.snapshotMsAverage() << " ms main thread per snapshot\n";
 }
 
+// Chunks whose blocks go unused this long are compressed in memory
+const float COLD_CHUNK_SECONDS = 20.0f;
+
+// Caps remeshing per frame so a freshly streamed ring spreads over a few frames
+const int MAX_REMESHES_PER_FRAME = 32;
+
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     glViewport(0, 0, width, height);
 }
-void getTileUV(int col, int row, float& uMin, float& vMin, float& uMax, float& vMax) {
-    uMin = col * TILE_SIZE;
-    vMin = row * TILE_SIZE;
-    uMax = uMin + TILE_SIZE;
-    vMax = vMin + TILE_SIZE;
-}
 void processInput(GLFWwindow* window, glm::vec3& cameraPos, glm::vec3& cameraFront, glm::vec3& cameraUp, float deltaTime) {
     float cameraSpeed = 2.5f * deltaTime;
     if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && isGrounded) {
@@ -76,71 +85,46 @@ void processInput(GLFWwindow* window, glm::vec3& cameraPos, glm::vec3& cameraFro
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
 }
-void generateChunk(Chunk& chunk, int chunkX, int chunkY, int chunkZ) {
-    for (int x = 0; x < CHUNK_SIZE; ++x) {
-        for (int z = 0; z < CHUNK_SIZE; ++z) {
-            int worldX = chunkX * CHUNK_SIZE + x;
-            int worldZ = chunkZ * CHUNK_SIZE + z;
-            int height = getHeight(worldX, worldZ);  // world height at (x,z)
-
-            for (int y = 0; y < CHUNK_SIZE; ++y) {
-                int worldY = chunkY * CHUNK_SIZE + y;
-
-                if (worldY <= height) {
-                    chunk.blocks[x][y][z] = 1; // Block is filled
-                }
-                else {
-                    chunk.blocks[x][y][z] = 0; // Air
-                }
-            }
-        }
-    }
-}
-void renderChunk(const Chunk& chunk, const glm::vec3& chunkPos, unsigned int shaderProgram, unsigned int mvpLoc, const glm::mat4& view, const glm::mat4& projection) {
-    for (int x = 0; x < CHUNK_SIZE; ++x) {
-        for (int y = 0; y < CHUNK_SIZE; ++y) {
-            for (int z = 0; z < CHUNK_SIZE; ++z) {
-                if (chunk.blocks[x][y][z] == 1) {
-                    glm::vec3 blockWorldPos = chunkPos + glm::vec3(x, y, z);
-                    glm::mat4 model = glm::translate(glm::mat4(1.0f), blockWorldPos);
-                    glm::mat4 mvp = projection * view * model;
-                    glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, glm::value_ptr(mvp));
-                    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-                }
-            }
-        }
-    }
-}
-
-bool isBlockSolid(const std::vector<Chunk>& chunks, const std::vector<glm::vec3>& chunkPositions, const glm::vec3& worldPos)
-{
-    int x = (int)floor(worldPos.x);
-    int y = (int)floor(worldPos.y);
-    int z = (int)floor(worldPos.z);
-
-    int chunkX = floor(x / CHUNK_SIZE);
-    int chunkY = floor(y / CHUNK_SIZE);
-    int chunkZ = floor(z / CHUNK_SIZE);
-
-    int localX = x % CHUNK_SIZE;
-    int localY = y % CHUNK_SIZE;
-    int localZ = z % CHUNK_SIZE;
-
-    // Adjust negative mods
-    if (localX < 0) localX += CHUNK_SIZE;
-    if (localY < 0) localY += CHUNK_SIZE;
-    if (localZ < 0) localZ += CHUNK_SIZE;
-
-    for (size_t i = 0; i < chunks.size(); ++i) {
-        glm::vec3 pos = chunkPositions[i];
-        if ((int)(pos.x / CHUNK_SIZE) == chunkX &&
-            (int)(pos.y / CHUNK_SIZE) == chunkY &&
-            (int)(pos.z / CHUNK_SIZE) == chunkZ) {
+// A chunk mesh built by a job, waiting for the main thread to upload it
+struct MeshResult {
+    int index;
+    uint64_t ticket;   // the chunk's remesh ticket when the job was queued
+    uint64_t version;  // chunk version the mesh was built from
+    int lodScale;
+    ChunkMesh mesh;
+    ChunkConnectivity connectivity;
+};
 
-            return chunks[i].blocks[localX][localY][localZ] == 1;
-        }
+// Meshes snapshots of the chunk and its neighbours on a job worker
+void submitRemesh(JobSystem& jobs, CompletionQueue<MeshResult>& results, const World& world, int index, int lodScale, uint64_t ticket) {
+    const glm::ivec3& coord = world.chunkCoord(index);
+    ChunkSnapshot blocks = world.chunk(index).snapshot();
+    std::vector<ChunkSnapshot> neighbours(FACE_COUNT);
+    for (int f = 0; f < FACE_COUNT; ++f) {
+        const Chunk* neighbour = world.getChunk(
+            coord.x + faceNormals[f][0], coord.y + faceNormals[f][1], coord.z + faceNormals[f][2]);
+        if (neighbour)
+            neighbours[f] = neighbour->snapshot();
     }
-    return false;
+    MeshMode mode = chunkMeshMode;
+
+    jobs.submit([&results, index, ticket, lodScale, blocks, neighbours, mode]() {
+        thread_local PaddedChunk padded;
+        MeshResult result;
+        result.index = index;
+        result.ticket = ticket;
+        result.version = blocks.version;
+        result.lodScale = lodScale;
+        const BlockStorage* neighbourBlocks[FACE_COUNT];
+        for (int f = 0; f < FACE_COUNT; ++f)
+            neighbourBlocks[f] = neighbours[f].blocks.get();
+        if (lodScale > 1)
+            buildLodChunkMesh(*blocks.blocks, neighbourBlocks, lodScale, padded, result.mesh);
+        else
+            meshChunk(*blocks.blocks, neighbourBlocks, padded, result.mesh, mode);
+        result.connectivity = computeConnectivity(*blocks.blocks);
+        results.push(std::move(result));
+    });
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -179,16 +163,29 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 
 
 int main() {
-    std::vector<Chunk> chunks;
-    std::vector<glm::vec3> chunkPositions;
-
-    for (int x = -1; x <= 1; ++x) {
-        for (int z = -1; z <= 1; ++z) {
-            Chunk chunk;
-            generateChunk(chunk, x, 0, z); // Use your perlin-based terrain
-            chunks.push_back(chunk);
-            chunkPositions.emplace_back(x * CHUNK_SIZE, 0, z * CHUNK_SIZE);
-
+    World world;
+
+    // Chunk generation, meshing and save compression run on these workers
+    JobSystem jobs;
+
+    // The area around the spawn is loaded up front so the player lands on terrain
+    StreamingSettings streamingSettings;
+    // Chunks are drawn out to the load radius, so the LOD rings are in view and
+    // meet the horizon cutout (streamer.completeArea())
+    const float chunkFarPlane = streamingSettings.viewDistance();
+    RegionStore regionStore("world");
+    WorldSaver worldSaver(regionStore, streamingSettings.minChunkY, streamingSettings.maxChunkY, jobs);
+    setTerrainGenerator(TERRAIN_DENSITY);
+    ChunkStreamer streamer(streamingSettings, &worldSaver, &jobs);
+    streamer.loadAll(world, cameraPos);
+
+    // Overhangs can sit above the heightmap, so stand on the top solid block
+    int spawnX = (int)std::floor(cameraPos.x);
+    int spawnZ = (int)std::floor(cameraPos.z);
+    for (int y = (streamingSettings.maxChunkY + 1) * CHUNK_SIZE - 1; y >= streamingSettings.minChunkY * CHUNK_SIZE; --y) {
+        if (world.getBlock(spawnX, y, spawnZ) != 0) {
+            cameraPos.y = (float)y + 2.0f;
+            break;
         }
     }
 
@@ -204,92 +201,49 @@ int main() {
         std::cerr << "File not found: " << texturePath << std::endl;
     }
   
-    // Vertex data
-   // UVs for each face
-    float top_uMin, top_vMin, top_uMax, top_vMax;
-    float bottom_uMin, bottom_vMin, bottom_uMax, bottom_vMax;
-    float front_uMin, front_vMin, front_uMax, front_vMax;
-    float back_uMin, back_vMin, back_uMax, back_vMax;
-    float left_uMin, left_vMin, left_uMax, left_vMax;
-    float right_uMin, right_vMin, right_uMax, right_vMax;
-
-    getTileUV(1, 1, front_uMin, front_vMin, front_uMax, front_vMax);  // Stone
-    getTileUV(2, 1, back_uMin, back_vMin, back_uMax, back_vMax);      // Cobble
-    getTileUV(3, 1, left_uMin, left_vMin, left_uMax, left_vMax);      // Wood
-    getTileUV(4, 1, right_uMin, right_vMin, right_uMax, right_vMax);  // Brick
-
-    getTileUV(0, 0, top_uMin, top_vMin, top_uMax, top_vMax);     // Grass top
-    getTileUV(0, 1, bottom_uMin, bottom_vMin, bottom_uMax, bottom_vMax); // Dirt
-   
-
-    float vertices[] = {
-        // Front face (Stone)
-        -0.5f, -0.5f,  0.5f,  front_uMin, front_vMax,
-         0.5f, -0.5f,  0.5f,  front_uMax, front_vMax,
-         0.5f,  0.5f,  0.5f,  front_uMax, front_vMin,
-        -0.5f,  0.5f,  0.5f,  front_uMin, front_vMin,
-
-        // Back face (Cobble)
-        -0.5f, -0.5f, -0.5f,  back_uMax, back_vMax,
-         0.5f, -0.5f, -0.5f,  back_uMin, back_vMax,
-         0.5f,  0.5f, -0.5f,  back_uMin, back_vMin,
-        -0.5f,  0.5f, -0.5f,  back_uMax, back_vMin,
-
-        // Left face (Wood)
-        -0.5f, -0.5f, -0.5f,  left_uMin, left_vMax,
-        -0.5f, -0.5f,  0.5f,  left_uMax, left_vMax,
-        -0.5f,  0.5f,  0.5f,  left_uMax, left_vMin,
-        -0.5f,  0.5f, -0.5f,  left_uMin, left_vMin,
-
-        // Right face (Brick)
-         0.5f, -0.5f, -0.5f,  right_uMax, right_vMax,
-         0.5f, -0.5f,  0.5f,  right_uMin, right_vMax,
-         0.5f,  0.5f,  0.5f,  right_uMin, right_vMin,
-         0.5f,  0.5f, -0.5f,  right_uMax, right_vMin,
-
-         // Top face (Grass Top)
-         -0.5f,  0.5f, -0.5f,  top_uMin, top_vMin,
-          0.5f,  0.5f, -0.5f,  top_uMax, top_vMin,
-          0.5f,  0.5f,  0.5f,  top_uMax, top_vMax,
-         -0.5f,  0.5f,  0.5f,  top_uMin, top_vMax,
-
-         // Bottom face (Dirt)
-         -0.5f, -0.5f, -0.5f,  bottom_uMin, bottom_vMax,
-          0.5f, -0.5f, -0.5f,  bottom_uMax, bottom_vMax,
-          0.5f, -0.5f,  0.5f,  bottom_uMax, bottom_vMin,
-         -0.5f, -0.5f,  0.5f,  bottom_uMin, bottom_vMin
-    };
-
-    unsigned int indices[] = {
-        0, 1, 2,  2, 3, 0,        // front
-        4, 5, 6,  6, 7, 4,        // back
-        8, 9,10, 10,11, 8,        // left
-       12,13,14, 14,15,12,        // right
-       16,17,18, 18,19,16,        // top
-       20,21,22, 22,23,20         // bottom
-    };
-
-
-
-
     // Vertex Shader source
     const char* vertexShaderSource = "#version 330 core\n"
-        "layout (location = 0) in vec3 aPos;\n"
-        "layout (location = 1) in vec2 aTexCoord;\n"
+        "layout (location = 0) in uint aData;\n"
         "out vec2 TexCoord;\n"
+        "out vec2 TileOrigin;\n"
+        "out float Shade;\n"
         "uniform mat4 mvp;\n"
+        "uniform int atlasColumns;\n"
+        "uniform int pageVertices;\n"
+        "uniform samplerBuffer chunkOrigins;\n"
+        "// Texture axes and direction per face (front, back, left, right, top, bottom)\n"
+        "const ivec2 faceAxes[6] = ivec2[6](ivec2(0, 1), ivec2(0, 1), ivec2(2, 1), ivec2(2, 1), ivec2(0, 2), ivec2(0, 2));\n"
+        "// Side faces run v up the block, so tiles like the grass side stand upright (the atlas is loaded flipped)\n"
+        "const vec2 faceSigns[6] = vec2[6](vec2(1, 1), vec2(-1, 1), vec2(1, 1), vec2(-1, 1), vec2(1, 1), vec2(1, -1));\n"
         "void main() {\n"
-        "   gl_Position = mvp * vec4(aPos, 1.0);\n"
-        "   TexCoord = aTexCoord;\n"
+        "   vec3 pos = vec3(aData & 31u, (aData >> 5) & 31u, (aData >> 10) & 31u);\n"
+        "   int face = int((aData >> 15) & 7u);\n"
+        "   int tile = int((aData >> 18) & 63u);\n"
+        "   float ao = float((aData >> 24) & 3u) / 3.0;\n"
+        "   float light = float((aData >> 26) & 15u) / 15.0;\n"
+        "   // gl_VertexID includes the draw's base vertex, so it identifies the arena page\n"
+        "   vec3 origin = texelFetch(chunkOrigins, gl_VertexID / pageVertices).xyz;\n"
+        "   gl_Position = mvp * vec4(origin + pos, 1.0);\n"
+        "   TexCoord = vec2(pos[faceAxes[face].x], pos[faceAxes[face].y]) * faceSigns[face];\n"
+        "   TileOrigin = vec2(tile % atlasColumns, tile / atlasColumns) / float(atlasColumns);\n"
+        "   Shade = (0.4 + 0.6 * ao) * light;\n"
         "}\0";
 
     // Fragment Shader source
     const char* fragmentShaderSource = "#version 330 core\n"
         "out vec4 FragColor;\n"
         "in vec2 TexCoord;\n"
+        "in vec2 TileOrigin;\n"
+        "in float Shade;\n"
         "uniform sampler2D ourTexture;\n"
+        "uniform int atlasColumns;\n"
         "void main() {\n"
-        "   FragColor = texture(ourTexture, TexCoord);\n"
+        "   // Repeat the tile across merged quads; gradients from the unwrapped UV keep mip selection seamless\n"
+        "   float tileSize = 1.0 / float(atlasColumns);\n"
+        "   vec2 uv = TileOrigin + fract(TexCoord) * tileSize;\n"
+        "   vec2 grad = TexCoord * tileSize;\n"
+        "   vec4 color = textureGrad(ourTexture, uv, dFdx(grad), dFdy(grad));\n"
+        "   FragColor = vec4(color.rgb * Shade, color.a);\n"
         "}\n";
 
     // Initialize GLFW
@@ -344,32 +298,11 @@ int main() {
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 
-    // Set up VAO and VBO
-    unsigned int VBO, VAO,EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-    
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glUseProgram(shaderProgram);
+    glUniform1i(glGetUniformLocation(shaderProgram, "atlasColumns"), ATLAS_COLUMNS);
+    glUniform1i(glGetUniformLocation(shaderProgram, "pageVertices"), PAGE_VERTICES);
+    glUniform1i(glGetUniformLocation(shaderProgram, "chunkOrigins"), ChunkArena::ORIGIN_TEXTURE_UNIT);
 
-
-    // Define vertex layout
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-
-    // Unbind
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
     unsigned int texture;
     glGenTextures(1, &texture);
     glBindTexture(GL_TEXTURE_2D, texture);
@@ -395,6 +328,62 @@ int main() {
     }
     stbi_image_free(data);
     glEnable(GL_DEPTH_TEST);
+
+    // Every chunk mesh lives in one shared arena, filled as mesh jobs finish
+    ChunkArena chunkArena;
+    chunkArena.init(256);
+    std::vector<ChunkArenaSlot> chunkSlots;
+    std::vector<int> chunkLodScales;
+    std::vector<uint64_t> chunkMeshTickets;  // bumped per queued remesh; older results are dropped
+    CompletionQueue<MeshResult> meshResults;
+    std::vector<MeshResult> finishedMeshes;
+
+    // World-space box of every chunk for frustum culling
+    BoundsList chunkBounds;
+    std::vector<unsigned char> chunkVisible;
+
+    // Face-to-face air connectivity per chunk, computed by its mesh job and
+    // taken with the mesh
+    std::vector<ChunkConnectivity> chunkConnectivity;
+    std::vector<unsigned char> chunkReachable;
+    ChunkLookup chunkLookup = [&](int chunkX, int chunkY, int chunkZ) {
+        return world.findChunk(chunkX, chunkY, chunkZ);
+    };
+    float lastStatsTime = 0.0f;
+    int meshedChunks = 0;
+    long long meshedTriangles = 0;
+    float lastAutosaveTime = 0.0f;
+
+    // Heightmap horizon fills everything outside the loaded chunks
+    HorizonRenderer horizon;
+    horizon.init();
+    glm::vec4 voxelArea(0.0f);
+    // Brings the per-chunk tables in line with the streamer's last update;
+    // entries are freed before their index is reused
+    auto syncStreamedChunks = [&]() {
+        for (int index : streamer.unloadedChunks())
+            chunkArena.release(chunkSlots[index]);
+        if ((int)chunkSlots.size() < world.chunkCapacity()) {
+            chunkSlots.resize(world.chunkCapacity());
+            chunkLodScales.resize(world.chunkCapacity(), 1);
+            chunkMeshTickets.resize(world.chunkCapacity(), 0);
+            chunkConnectivity.resize(world.chunkCapacity());
+            while ((int)chunkBounds.size() < world.chunkCapacity())
+                chunkBounds.add(glm::vec3(0.0f), glm::vec3(0.0f));
+        }
+        for (int index : streamer.loadedChunks()) {
+            glm::vec3 pos = world.chunkOrigin(index);
+            chunkBounds.set(index, pos - glm::vec3(0.5f), pos - glm::vec3(0.5f) + glm::vec3((float)CHUNK_SIZE));
+            chunkConnectivity[index] = ChunkConnectivity::open();  // until its first mesh job lands
+        }
+
+        // The horizon steps aside only where every column is loaded, which is
+        // inside the chunk far plane
+        if (streamer.completeRadius() >= 0)
+            voxelArea = streamer.completeArea();
+    };
+    syncStreamedChunks();
+
     std::vector<glm::vec3> cubePositions = {
       { 0.0f,  0.0f,  0.0f},
       { 2.0f,  5.0f, -15.0f},
@@ -431,7 +420,7 @@ cameraPos.y += playerYVelocity * deltaTime;
 // Correct feet offset
 glm::vec3 feet = cameraPos + glm::vec3(0.0f, -1.8f, 0.0f);  // exact foot point
 
-if (isBlockSolid(chunks, chunkPositions, feet) && playerYVelocity < 0.0f) {
+if (world.isBlockSolid(feet) && playerYVelocity < 0.0f) {
     // Land on block: snap exactly to top of block
     cameraPos.y = floor(cameraPos.y - 1.8f) + 2.8f;  // 1.8 offset + block height (1)
     playerYVelocity = 0.0f;
@@ -446,17 +435,117 @@ if (isBlockSolid(chunks, chunkPositions, feet) && playerYVelocity < 0.0f) {
 
       
 
+        // Stream chunks around the player
+        streamer.update(world, cameraPos);
+        syncStreamedChunks();
+
         glm::mat4 projection = glm::perspective(glm::radians(45.0f),
-            800.0f / 600.0f, 0.1f, 100.0f);
+            800.0f / 600.0f, 0.1f, chunkFarPlane);
+
+        // Horizon first with its own far plane, then clear depth so chunks always draw over it
+        glm::mat4 horizonProjection = glm::perspective(glm::radians(45.0f),
+            800.0f / 600.0f, 0.1f, HORIZON_FAR_PLANE);
+        horizon.update(cameraPos, 2);
+        horizon.draw(view, horizonProjection, cameraPos, voxelArea, glm::vec3(0.52f, 0.80f, 0.92f));
+        glClear(GL_DEPTH_BUFFER_BIT);
 
         unsigned int mvpLoc = glGetUniformLocation(shaderProgram, "mvp");
 
         glUseProgram(shaderProgram);
         glBindTexture(GL_TEXTURE_2D, texture);
-        glBindVertexArray(VAO);
 
-        for (size_t i = 0; i < chunks.size(); ++i) {
-            renderChunk(chunks[i], chunkPositions[i], shaderProgram, mvpLoc, view, projection);
+        // Rebake only the chunks whose blocks or level of detail changed since the last upload
+        int remeshes = 0;
+        for (int i = 0; i < world.chunkCapacity() && remeshes < MAX_REMESHES_PER_FRAME; ++i) {
+            if (!world.isLoaded(i))
+                continue;
+            glm::vec3 chunkCentre = world.chunkOrigin(i) + glm::vec3(CHUNK_SIZE / 2.0f - 0.5f);
+            float distance = glm::length(chunkCentre - cameraPos);
+            // Chunks kept past the load radius until they unload are never drawn;
+            // they stay dirty and mesh if they come back into range
+            if (distance - CHUNK_SIZE * 0.87f > chunkFarPlane)
+                continue;
+            int lodScale = lodScaleForDistance(distance);
+            if (!world.chunk(i).dirty && lodScale == chunkLodScales[i])
+                continue;
+            chunkLodScales[i] = lodScale;
+            submitRemesh(jobs, meshResults, world, i, lodScale, ++chunkMeshTickets[i]);
+            world.chunk(i).dirty = false;
+            ++remeshes;
+        }
+
+        // Upload the meshes finished since the last frame. One built from blocks
+        // that were edited, unloaded or queued for remeshing again is stale.
+        meshResults.drain(finishedMeshes);
+        for (const MeshResult& result : finishedMeshes) {
+            int index = result.index;
+            if (!world.isLoaded(index) || result.ticket != chunkMeshTickets[index] ||
+                !world.chunk(index).isCurrent(result.version))
+                continue;
+            chunkArena.upload(chunkSlots[index], result.mesh, world.chunkOrigin(index));
+            chunkConnectivity[index] = result.connectivity;
+            ++meshedChunks;
+            meshedTriangles += result.mesh.triangleCount();
+            if (logMeshedChunks) {
+                const glm::ivec3& coord = world.chunkCoord(index);
+                std::cout << "Meshed chunk (" << coord.x << ", " << coord.y << ", " << coord.z << "): "
+                          << result.mesh.triangleCount() << " triangles (LOD x" << result.lodScale << ")\n";
+            }
+        }
+        finishedMeshes.clear();
+
+        // Mesh vertices sit on block corners; blocks are drawn centred on their position
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(-0.5f));
+        glm::mat4 mvp = projection * view * model;
+        glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, glm::value_ptr(mvp));
+
+        // Only chunks inside the view frustum and reachable through air from the camera are submitted
+        cullBounds(extractFrustum(projection * view), chunkBounds, chunkVisible);
+        glm::ivec3 cameraChunk = glm::floor((cameraPos + glm::vec3(0.5f)) / (float)CHUNK_SIZE);
+        findVisibleChunks(cameraChunk, chunkLookup, chunkConnectivity, chunkReachable);
+
+        int visibleChunks = 0, frustumCulled = 0, occlusionCulled = 0;
+        for (int i = 0; i < world.chunkCapacity(); ++i) {
+            if (!world.isLoaded(i))
+                continue;
+            if (!chunkVisible[i]) {
+                ++frustumCulled;
+            }
+            else if (!chunkReachable[i]) {
+                ++occlusionCulled;
+            }
+            else {
+                chunkArena.addDraw(chunkSlots[i]);
+                ++visibleChunks;
+            }
+        }
+        chunkArena.flushDraws();
+
+        if (currentFrame - lastStatsTime >= 1.0f) {
+            world.compressColdChunks(currentFrame - lastStatsTime, COLD_CHUNK_SECONDS);
+            ColdTierStats cold = world.coldTierStats();
+            std::string title = "OpenGL Window - chunks visible: " + std::to_string(visibleChunks) +
+                                ", frustum culled: " + std::to_string(frustumCulled) +
+                                ", occlusion culled: " + std::to_string(occlusionCulled) +
+                                ", loaded: " + std::to_string(world.loadedCount()) +
+                                ", pending columns: " + std::to_string(streamer.pendingCount()) +
+                                ", meshed: " + std::to_string(meshedChunks) + " (" +
+                                std::to_string(meshedChunks ? (int)(meshedTriangles / meshedChunks) : 0) + " tris avg)" +
+                                ", cold: " + std::to_string(cold.coldChunks) + " (" + std::to_string(cold.coldBytes / 1024) +
+                                " KiB vs " + std::to_string(cold.hotBytes / 1024) + " KiB hot, hit rate " +
+                                std::to_string((int)(cold.hitRate() * 100.0)) + "%, " +
+                                std::to_string((int)cold.averageDecompressMicros) + " us/decompress)";
+            glfwSetWindowTitle(window, title.c_str());
+            lastStatsTime = currentFrame;
+            meshedChunks = 0;
+            meshedTriangles = 0;
+        }
+
+        // Changed chunks are snapshotted here and written out on background threads
+        if (currentFrame - lastAutosaveTime >= AUTOSAVE_INTERVAL) {
+            worldSaver.saveUnsaved(world);
+            printSaveStats(worldSaver.stats());
+            lastAutosaveTime = currentFrame;
         }
 
 
@@ -465,8 +554,12 @@ if (isBlockSolid(chunks, chunkPositions, feet) && playerYVelocity < 0.0f) {
     }
 
     // Cleanup
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    jobs.waitIdle();
+    worldSaver.saveUnsaved(world);
+    worldSaver.flush();
+    printSaveStats(worldSaver.stats());
+    chunkArena.destroy();
+    horizon.destroy();
     glDeleteProgram(shaderProgram);
 
     glfwDestroyWindow(window);
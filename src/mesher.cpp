@@ -0,0 +1,372 @@
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include "mesher.h"
+#include "terrain.h"
+
+struct FaceDef {
+    int corners[4][3];  // cube corner offsets (0/1)
+    int uAxis, vAxis;   // block axes the texture u/v run along
+    int tileCol, tileRow;  // for block ids without their own tiles
+};
+
+// Matches the per-block cube the renderer used to draw
+static const FaceDef faceDefs[FACE_COUNT] = {
+    { {{0,0,1}, {1,0,1}, {1,1,1}, {0,1,1}}, 0, 1, 1, 1 },  // Front face (Stone)
+    { {{0,0,0}, {1,0,0}, {1,1,0}, {0,1,0}}, 0, 1, 2, 1 },  // Back face (Cobble)
+    { {{0,0,0}, {0,0,1}, {0,1,1}, {0,1,0}}, 2, 1, 3, 1 },  // Left face (Wood)
+    { {{1,0,0}, {1,0,1}, {1,1,1}, {1,1,0}}, 2, 1, 4, 1 },  // Right face (Brick)
+    { {{0,1,0}, {1,1,0}, {1,1,1}, {0,1,1}}, 0, 2, 0, 0 },  // Top face (Grass Top)
+    { {{0,0,0}, {1,0,0}, {1,0,1}, {0,0,1}}, 0, 2, 0, 1 },  // Bottom face (Dirt)
+};
+
+static int atlasTile(int col, int row) {
+    return row * ATLAS_COLUMNS + col;
+}
+
+// Atlas tile of a block's face. Rows count up from the bottom of atlas.png,
+// which is loaded flipped.
+static int blockTile(int block, int f) {
+    bool top = f == FACE_TOP, bottom = f == FACE_BOTTOM;
+    switch (block) {
+    case BLOCK_STONE:
+        return atlasTile(1, 3);
+    case BLOCK_DIRT:
+        return atlasTile(2, 0);
+    case BLOCK_GRASS:
+        return top ? atlasTile(3, 2) : bottom ? atlasTile(2, 0) : atlasTile(1, 0);
+    case BLOCK_LOG:
+        return top || bottom ? atlasTile(0, 4) : atlasTile(0, 3);
+    case BLOCK_LEAVES:
+        return atlasTile(4, 3);
+    default:
+        return atlasTile(faceDefs[f].tileCol, faceDefs[f].tileRow);
+    }
+}
+
+// Emits one quad of block covering size[] blocks starting at (x, y, z); size is 1 along the face normal
+static void emitQuad(ChunkMesh& mesh, int x, int y, int z, const int size[3], int f, int block) {
+    const FaceDef& face = faceDefs[f];
+    int tile = blockTile(block, f);
+
+    unsigned int base = (unsigned int)mesh.vertices.size();
+    for (int i = 0; i < 4; ++i) {
+        mesh.vertices.push_back(packVertex(
+            x + face.corners[i][0] * size[0],
+            y + face.corners[i][1] * size[1],
+            z + face.corners[i][2] * size[2],
+            f, tile, VERTEX_AO_MAX, VERTEX_LIGHT_MAX));
+    }
+
+    const unsigned int quad[6] = { 0, 1, 2, 2, 3, 0 };
+    for (unsigned int i : quad)
+        mesh.indices.push_back(base + i);
+}
+
+static void emitFace(ChunkMesh& mesh, int x, int y, int z, int f, int block) {
+    const int unit[3] = { 1, 1, 1 };
+    emitQuad(mesh, x, y, z, unit, f, block);
+}
+
+void padChunk(const BlockStorage& blocks, const BlockStorage* const neighbours[FACE_COUNT], PaddedChunk& padded) {
+    const int S = PaddedChunk::SIZE;
+    for (int x = 0; x < S; ++x)
+        for (int y = 0; y < S; ++y)
+            for (int z = 0; z < S; ++z)
+                padded.blocks[x][y][z] = 0;
+
+    int dense[CHUNK_VOLUME];
+    blocks.unpack(dense);
+    for (int x = 0; x < CHUNK_SIZE; ++x)
+        for (int y = 0; y < CHUNK_SIZE; ++y)
+            for (int z = 0; z < CHUNK_SIZE; ++z)
+                padded.blocks[x + 1][y + 1][z + 1] = dense[BlockStorage::index(x, y, z)];
+
+    // Copy the touching layer of each neighbour into the border
+    const int last = CHUNK_SIZE - 1;
+    for (int a = 0; a < CHUNK_SIZE; ++a) {
+        for (int b = 0; b < CHUNK_SIZE; ++b) {
+            if (neighbours[FACE_RIGHT])
+                padded.blocks[S - 1][a + 1][b + 1] = neighbours[FACE_RIGHT]->get(0, a, b);
+            if (neighbours[FACE_LEFT])
+                padded.blocks[0][a + 1][b + 1] = neighbours[FACE_LEFT]->get(last, a, b);
+            if (neighbours[FACE_TOP])
+                padded.blocks[a + 1][S - 1][b + 1] = neighbours[FACE_TOP]->get(a, 0, b);
+            if (neighbours[FACE_BOTTOM])
+                padded.blocks[a + 1][0][b + 1] = neighbours[FACE_BOTTOM]->get(a, last, b);
+            if (neighbours[FACE_FRONT])
+                padded.blocks[a + 1][b + 1][S - 1] = neighbours[FACE_FRONT]->get(a, b, 0);
+            if (neighbours[FACE_BACK])
+                padded.blocks[a + 1][b + 1][0] = neighbours[FACE_BACK]->get(a, b, last);
+        }
+    }
+}
+
+// Visible block id of face f at each (u, v) cell of every slice along its normal,
+// merged into rectangles: grow along u, then along v while the whole row matches.
+// With step > 1 the padded blocks come in uniform step^3 cells (see
+// buildLodChunkMesh) and each cell is one entry of the mask.
+static void buildGreedyFaces(const PaddedChunk& padded, ChunkMesh& mesh, int f, int step = 1) {
+    const FaceDef& face = faceDefs[f];
+    const int* n = faceNormals[f];
+    const int uAxis = face.uAxis;
+    const int vAxis = face.vAxis;
+    const int dAxis = 3 - uAxis - vAxis;
+    const int cells = CHUNK_SIZE / step;
+    // From a cell's first block to the nearest block of the cell it faces
+    const int reach = n[dAxis] > 0 ? step : 1;
+
+    int mask[CHUNK_SIZE][CHUNK_SIZE];
+    for (int d = 0; d < CHUNK_SIZE; d += step) {
+        int p[3];
+        p[dAxis] = d;
+        for (int u = 0; u < cells; ++u) {
+            for (int v = 0; v < cells; ++v) {
+                p[uAxis] = u * step;
+                p[vAxis] = v * step;
+                int block = padded.at(p[0], p[1], p[2]);
+                bool visible = block != 0 &&
+                               padded.at(p[0] + n[0] * reach, p[1] + n[1] * reach, p[2] + n[2] * reach) == 0;
+                mask[u][v] = visible ? block : 0;
+            }
+        }
+
+        for (int v = 0; v < cells; ++v) {
+            for (int u = 0; u < cells; ) {
+                int block = mask[u][v];
+                if (block == 0) {
+                    ++u;
+                    continue;
+                }
+
+                int w = 1;
+                while (u + w < cells && mask[u + w][v] == block)
+                    ++w;
+
+                int h = 1;
+                for (; v + h < cells; ++h) {
+                    bool rowMatches = true;
+                    for (int k = 0; k < w; ++k) {
+                        if (mask[u + k][v + h] != block) {
+                            rowMatches = false;
+                            break;
+                        }
+                    }
+                    if (!rowMatches)
+                        break;
+                }
+
+                for (int j = 0; j < h; ++j)
+                    for (int k = 0; k < w; ++k)
+                        mask[u + k][v + j] = 0;
+
+                int size[3];
+                size[dAxis] = step;
+                size[uAxis] = w * step;
+                size[vAxis] = h * step;
+                p[uAxis] = u * step;
+                p[vAxis] = v * step;
+                emitQuad(mesh, p[0], p[1], p[2], size, f, block);
+                u += w;
+            }
+        }
+    }
+}
+
+static int countTrailingZeros(uint64_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+// Each padded row along an axis becomes one 64-bit occupancy word (bit i = block i solid).
+// A face towards +axis is visible where a bit is set and the next one is clear,
+// so a whole row is culled with one shift, one AND-NOT and a scan of the set bits.
+static void buildBinaryFaces(const PaddedChunk& padded, ChunkMesh& mesh) {
+    static_assert(PaddedChunk::SIZE <= 64, "padded rows must fit in a 64-bit column");
+    const int S = PaddedChunk::SIZE;
+
+    // columns[axis][a][b], where (a, b) are the two other axes in x, y, z order
+    uint64_t columns[3][S][S] = {};
+    for (int x = 0; x < S; ++x) {
+        for (int y = 0; y < S; ++y) {
+            for (int z = 0; z < S; ++z) {
+                uint64_t solid = padded.blocks[x][y][z] != 0;
+                columns[0][y][z] |= solid << x;
+                columns[1][x][z] |= solid << y;
+                columns[2][x][y] |= solid << z;
+            }
+        }
+    }
+
+    const uint64_t inner = (1ull << CHUNK_SIZE) - 1;
+    for (int f = 0; f < FACE_COUNT; ++f) {
+        const int* n = faceNormals[f];
+        int axis = n[0] != 0 ? 0 : (n[1] != 0 ? 1 : 2);
+        bool positive = n[axis] > 0;
+        int aAxis = axis == 0 ? 1 : 0;
+        int bAxis = axis == 2 ? 1 : 2;
+
+        for (int a = 1; a <= CHUNK_SIZE; ++a) {
+            for (int b = 1; b <= CHUNK_SIZE; ++b) {
+                uint64_t column = columns[axis][a][b];
+                uint64_t visible = positive ? column & ~(column >> 1) : column & ~(column << 1);
+                visible = (visible >> 1) & inner;  // drop the padding bits
+
+                while (visible) {
+                    int p[3];
+                    p[axis] = countTrailingZeros(visible);
+                    p[aAxis] = a - 1;
+                    p[bAxis] = b - 1;
+                    emitFace(mesh, p[0], p[1], p[2], f, padded.at(p[0], p[1], p[2]));
+                    visible &= visible - 1;
+                }
+            }
+        }
+    }
+}
+
+void buildChunkMesh(const PaddedChunk& padded, ChunkMesh& mesh, MeshMode mode) {
+    mesh.clear();
+    if (mode == MESH_GREEDY) {
+        for (int f = 0; f < FACE_COUNT; ++f)
+            buildGreedyFaces(padded, mesh, f);
+        return;
+    }
+    if (mode == MESH_BINARY) {
+        buildBinaryFaces(padded, mesh);
+        return;
+    }
+
+    for (int x = 0; x < CHUNK_SIZE; ++x) {
+        for (int y = 0; y < CHUNK_SIZE; ++y) {
+            for (int z = 0; z < CHUNK_SIZE; ++z) {
+                int block = padded.at(x, y, z);
+                if (block == 0)
+                    continue;
+                for (int f = 0; f < FACE_COUNT; ++f) {
+                    // Hidden face: the neighbour in that direction is solid
+                    if (mode == MESH_CULLED &&
+                        padded.at(x + faceNormals[f][0], y + faceNormals[f][1], z + faceNormals[f][2]) != 0)
+                        continue;
+                    emitFace(mesh, x, y, z, f, block);
+                }
+            }
+        }
+    }
+}
+
+// Every neighbour is loaded and all solid, so none of the chunk's border faces show
+static bool boxedInBySolid(const BlockStorage* const neighbours[FACE_COUNT]) {
+    for (int f = 0; f < FACE_COUNT; ++f) {
+        const BlockStorage* n = neighbours[f];
+        if (!n || !n->isUniform() || n->uniformBlock() == 0)
+            return false;
+    }
+    return true;
+}
+
+void meshChunk(const BlockStorage& blocks, const BlockStorage* const neighbours[FACE_COUNT], PaddedChunk& padded,
+               ChunkMesh& mesh, MeshMode mode) {
+    if (blocks.isUniform()) {
+        bool empty = blocks.uniformBlock() == 0 || (mode != MESH_NAIVE && boxedInBySolid(neighbours));
+        if (empty) {
+            mesh.clear();
+            return;
+        }
+    }
+
+    padChunk(blocks, neighbours, padded);
+    buildChunkMesh(padded, mesh, mode);
+}
+
+static_assert(CHUNK_SIZE % 4 == 0, "LOD cells must tile the chunk");
+
+int lodScaleForDistance(float distance) {
+    if (distance < LOD_NEAR_DISTANCE)
+        return 1;
+    if (distance < LOD_FAR_DISTANCE)
+        return 2;
+    return 4;
+}
+
+// Border of a LOD chunk from its neighbours' touching layers. A lodScale x
+// lodScale patch counts as solid only when every block in it is, so a coarse
+// border face is dropped only where the neighbour's own mesh covers all of it.
+static void padLodBorder(const BlockStorage* const neighbours[FACE_COUNT], int lodScale, PaddedChunk& expanded) {
+    const int last = CHUNK_SIZE - 1;
+    for (int f = 0; f < FACE_COUNT; ++f) {
+        const BlockStorage* neighbour = neighbours[f];
+        if (!neighbour)
+            continue;  // missing: air, so the side is a closed wall
+        const int* n = faceNormals[f];
+        int axis = n[0] != 0 ? 0 : (n[1] != 0 ? 1 : 2);
+        int aAxis = axis == 0 ? 1 : 0;
+        int bAxis = axis == 2 ? 1 : 2;
+        int q[3], r[3];
+        q[axis] = n[axis] > 0 ? 0 : last;                   // the neighbour's touching layer
+        r[axis] = n[axis] > 0 ? PaddedChunk::SIZE - 1 : 0;  // the border layer it pads
+        for (int pa = 0; pa < CHUNK_SIZE; pa += lodScale) {
+            for (int pb = 0; pb < CHUNK_SIZE; pb += lodScale) {
+                int patch = 1;  // ends as 0 at the first air block
+                for (int i = 0; i < lodScale && patch != 0; ++i) {
+                    for (int j = 0; j < lodScale && patch != 0; ++j) {
+                        q[aAxis] = pa + i;
+                        q[bAxis] = pb + j;
+                        patch = neighbour->get(q[0], q[1], q[2]);
+                    }
+                }
+                for (int i = 0; i < lodScale; ++i) {
+                    for (int j = 0; j < lodScale; ++j) {
+                        r[aAxis] = pa + i + 1;
+                        r[bAxis] = pb + j + 1;
+                        expanded.blocks[r[0]][r[1]][r[2]] = patch;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void buildLodChunkMesh(const BlockStorage& blocks, const BlockStorage* const neighbours[FACE_COUNT], int lodScale,
+                       PaddedChunk& expanded, ChunkMesh& mesh) {
+    mesh.clear();
+    if (blocks.isUniform() && (blocks.uniformBlock() == 0 || boxedInBySolid(neighbours)))
+        return;
+
+    const int S = PaddedChunk::SIZE;
+    for (int x = 0; x < S; ++x)
+        for (int y = 0; y < S; ++y)
+            for (int z = 0; z < S; ++z)
+                expanded.blocks[x][y][z] = 0;
+
+    int dense[CHUNK_VOLUME];
+    blocks.unpack(dense);
+    for (int cx = 0; cx < CHUNK_SIZE; cx += lodScale) {
+        for (int cy = 0; cy < CHUNK_SIZE; cy += lodScale) {
+            for (int cz = 0; cz < CHUNK_SIZE; cz += lodScale) {
+                // The topmost solid block, so a grassy cell stays grass from afar
+                int cell = 0;
+                for (int y = cy + lodScale - 1; y >= cy && cell == 0; --y)
+                    for (int x = cx; x < cx + lodScale && cell == 0; ++x)
+                        for (int z = cz; z < cz + lodScale && cell == 0; ++z)
+                            cell = dense[BlockStorage::index(x, y, z)];
+
+                for (int x = cx; x < cx + lodScale; ++x)
+                    for (int y = cy; y < cy + lodScale; ++y)
+                        for (int z = cz; z < cz + lodScale; ++z)
+                            expanded.blocks[x + 1][y + 1][z + 1] = cell;
+            }
+        }
+    }
+    padLodBorder(neighbours, lodScale, expanded);
+
+    // Greedy merging over whole cells, so each uniform cell costs one mask entry
+    for (int f = 0; f < FACE_COUNT; ++f)
+        buildGreedyFaces(expanded, mesh, f, lodScale);
+}
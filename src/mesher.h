@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "chunk.h"
+
+#define ATLAS_COLUMNS 6
+#define TILE_SIZE (1.0f / ATLAS_COLUMNS)
+#define TILE_U(col) ((col) * TILE_SIZE)
+#define TILE_V(row) ((row) * TILE_SIZE)
+
+inline void getTileUV(int col, int row, float& uMin, float& vMin, float& uMax, float& vMax) {
+    uMin = col * TILE_SIZE;
+    vMin = row * TILE_SIZE;
+    uMax = uMin + TILE_SIZE;
+    vMax = vMin + TILE_SIZE;
+}
+
+// Packed chunk vertex, 4 bytes, decoded in the vertex shader:
+//   bits  0-14  x, y, z corner position inside the chunk (5 bits each, 0..CHUNK_SIZE)
+//   bits 15-17  face index (Face), which also gives the texture orientation
+//   bits 18-23  atlas tile index (row * ATLAS_COLUMNS + col)
+//   bits 24-25  ambient occlusion (3 = unoccluded)
+//   bits 26-29  light level (15 = full)
+// UVs are derived from the position, so greedy quads tile without extra bits.
+struct ChunkVertex {
+    uint32_t data;
+};
+
+static_assert(CHUNK_SIZE < 32, "packed vertex positions are 5 bits");
+
+const int VERTEX_AO_MAX = 3;
+const int VERTEX_LIGHT_MAX = 15;
+
+inline ChunkVertex packVertex(int x, int y, int z, int face, int tile, int ao, int light) {
+    ChunkVertex v;
+    v.data = (uint32_t)x | (uint32_t)y << 5 | (uint32_t)z << 10 | (uint32_t)face << 15 |
+             (uint32_t)tile << 18 | (uint32_t)ao << 24 | (uint32_t)light << 26;
+    return v;
+}
+
+inline int vertexX(ChunkVertex v) { return v.data & 31; }
+inline int vertexY(ChunkVertex v) { return (v.data >> 5) & 31; }
+inline int vertexZ(ChunkVertex v) { return (v.data >> 10) & 31; }
+inline int vertexFace(ChunkVertex v) { return (v.data >> 15) & 7; }
+inline int vertexTile(ChunkVertex v) { return (v.data >> 18) & 63; }
+
+// CPU-side geometry for one chunk, positions local to the chunk's corner
+struct ChunkMesh {
+    std::vector<ChunkVertex> vertices;
+    std::vector<unsigned int> indices;
+
+    void clear() {
+        vertices.clear();
+        indices.clear();
+    }
+
+    int triangleCount() const { return (int)indices.size() / 3; }
+};
+
+enum Face {
+    FACE_FRONT,   // +Z
+    FACE_BACK,    // -Z
+    FACE_LEFT,    // -X
+    FACE_RIGHT,   // +X
+    FACE_TOP,     // +Y
+    FACE_BOTTOM,  // -Y
+    FACE_COUNT
+};
+
+// Unit step towards the neighbour each face looks at
+const int faceNormals[FACE_COUNT][3] = {
+    { 0, 0, 1 }, { 0, 0, -1 }, { -1, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }
+};
+
+// Chunk blocks plus a one-block border copied from the six face neighbours,
+// so the mesher never has to look outside this array
+struct PaddedChunk {
+    static const int SIZE = CHUNK_SIZE + 2;
+    int blocks[SIZE][SIZE][SIZE];
+
+    // Local chunk coordinates, valid from -1 to CHUNK_SIZE
+    int at(int x, int y, int z) const { return blocks[x + 1][y + 1][z + 1]; }
+};
+
+// Missing neighbours (nullptr) are treated as air so border faces still show
+void padChunk(const BlockStorage& blocks, const BlockStorage* const neighbours[FACE_COUNT], PaddedChunk& padded);
+
+enum MeshMode {
+    MESH_NAIVE,   // all six faces of every solid block
+    MESH_CULLED,  // only faces that touch air
+    MESH_GREEDY,  // culled faces merged into maximal same-block rectangles per slice
+    MESH_BINARY   // same faces as MESH_CULLED, found with bit ops over 64-bit occupancy columns
+};
+
+// Bakes the solid blocks of the chunk into a single vertex/index buffer
+void buildChunkMesh(const PaddedChunk& padded, ChunkMesh& mesh, MeshMode mode = MESH_CULLED);
+
+// padChunk + buildChunkMesh, skipping both when the result is known to be
+// empty: an all-air chunk, or an all-solid one boxed in by all-solid neighbours
+void meshChunk(const BlockStorage& blocks, const BlockStorage* const neighbours[FACE_COUNT], PaddedChunk& padded,
+               ChunkMesh& mesh, MeshMode mode = MESH_CULLED);
+
+// === Level of detail ===
+// Distant chunks are meshed from lodScale^3 block cells (lodScale 2 or 4).
+// A cell is solid if any block in it is, so the coarse surface always covers
+// the real one. A border face is hidden only where the neighbour's blocks
+// cover the whole cell face, and sides without a loaded neighbour are closed
+// walls. Together that hides the cracks between neighbours meshed at
+// different levels without walling off every chunk.
+const int LOD_NEAR_DISTANCE = 4 * CHUNK_SIZE;  // full detail inside this many blocks
+const int LOD_FAR_DISTANCE = 8 * CHUNK_SIZE;   // half detail inside this, quarter beyond
+
+int lodScaleForDistance(float distance);
+
+// Neighbours are read like meshChunk's, and a solid chunk boxed in by solid
+// neighbours is skipped the same way. expanded is scratch space for the coarse
+// cells spread back to block resolution.
+void buildLodChunkMesh(const BlockStorage& blocks, const BlockStorage* const neighbours[FACE_COUNT], int lodScale,
+                       PaddedChunk& expanded, ChunkMesh& mesh);
@@ -0,0 +1,396 @@
+#include <cmath>
+#include <cstring>
+#include "noise.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define NOISE_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define NOISE_TARGET(isa)
+#else
+#define NOISE_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+// The SIMD paths must round exactly like the scalar one, so nothing here may be
+// fused into FMA; the build compiles this file with contraction off.
+
+const uint32_t HASH_X = 0x27d4eb2du;
+const uint32_t HASH_Z = 0x165667b1u;
+const uint32_t HASH_Y = 0x1b873593u;
+const uint32_t HASH_MIX = 0x2c1b3c6du;
+const uint32_t OCTAVE_SEED_STEP = 0x9e3779b9u;
+
+// Keeps the sum of the two weighted gradients inside [-1, 1]
+const float NOISE_SCALE = 0.5f;
+// The 3D edge gradients peak just above 1 (about 1.036)
+const float NOISE_SCALE3 = 0.96f;
+
+// === Scalar reference ===
+
+static inline uint32_t hashCorner(int32_t ix, int32_t iz, uint32_t seed) {
+    uint32_t h = ((uint32_t)ix * HASH_X) ^ ((uint32_t)iz * HASH_Z) ^ seed;
+    h ^= h >> 15;
+    h *= HASH_MIX;
+    h ^= h >> 12;
+    return h;
+}
+
+// Flips the sign bit, the way the SIMD paths negate; branches on random hash
+// bits would mispredict half the time
+static inline float flipSign(float value, uint32_t signBit) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    bits ^= signBit;
+    std::memcpy(&value, &bits, 4);
+    return value;
+}
+
+// One of eight gradients picked by the low hash bits: (±1, ±2) or (±2, ±1)
+static inline float gradient(uint32_t h, float x, float z) {
+    float u = (h & 4) ? z : x;
+    float v = (h & 4) ? x : z;
+    return flipSign(u, (h & 1) << 31) + flipSign(2.0f * v, (h & 2) << 30);
+}
+
+static inline float fade(float t) {
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static inline float lerp(float a, float b, float t) {
+    return a + t * (b - a);
+}
+
+float gradientNoise(float x, float z, uint32_t seed) {
+    float x0 = std::floor(x);
+    float z0 = std::floor(z);
+    float fx = x - x0;
+    float fz = z - z0;
+    int32_t ix = (int32_t)x0;
+    int32_t iz = (int32_t)z0;
+
+    float n00 = gradient(hashCorner(ix, iz, seed), fx, fz);
+    float n10 = gradient(hashCorner(ix + 1, iz, seed), fx - 1.0f, fz);
+    float n01 = gradient(hashCorner(ix, iz + 1, seed), fx, fz - 1.0f);
+    float n11 = gradient(hashCorner(ix + 1, iz + 1, seed), fx - 1.0f, fz - 1.0f);
+
+    float u = fade(fx);
+    float v = fade(fz);
+    return lerp(lerp(n00, n10, u), lerp(n01, n11, u), v) * NOISE_SCALE;
+}
+
+float fractalNoise(const NoiseSettings& settings, float x, float z) {
+    float sum = 0.0f;
+    float total = 0.0f;
+    float amplitude = 1.0f;
+    float frequency = settings.frequency;
+    for (int octave = 0; octave < settings.octaves; ++octave) {
+        uint32_t seed = settings.seed + (uint32_t)octave * OCTAVE_SEED_STEP;
+        sum = sum + amplitude * gradientNoise(x * frequency, z * frequency, seed);
+        total = total + amplitude;
+        amplitude = amplitude * settings.gain;
+        frequency = frequency * settings.lacunarity;
+    }
+    return total > 0.0f ? sum / total : 0.0f;
+}
+
+static void fractalNoiseScalar(const NoiseSettings& settings, const float* x, const float* z, float* out, int count) {
+    for (int i = 0; i < count; ++i)
+        out[i] = fractalNoise(settings, x[i], z[i]);
+}
+
+// === 3D, scalar only ===
+// Density terrain samples this on a coarse lattice, a few hundred points per
+// chunk, so it has no SIMD path.
+
+static inline uint32_t hashCorner3(int32_t ix, int32_t iy, int32_t iz, uint32_t seed) {
+    uint32_t h = ((uint32_t)ix * HASH_X) ^ ((uint32_t)iy * HASH_Y) ^ ((uint32_t)iz * HASH_Z) ^ seed;
+    h ^= h >> 15;
+    h *= HASH_MIX;
+    h ^= h >> 12;
+    return h;
+}
+
+// One of the twelve cube edge directions, as in improved Perlin noise
+static inline float gradient3(uint32_t h, float x, float y, float z) {
+    h &= 15;
+    float u = h < 8 ? x : y;
+    float v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+    return flipSign(u, (h & 1) << 31) + flipSign(v, (h & 2) << 30);
+}
+
+float gradientNoise3(float x, float y, float z, uint32_t seed) {
+    float x0 = std::floor(x);
+    float y0 = std::floor(y);
+    float z0 = std::floor(z);
+    float fx = x - x0;
+    float fy = y - y0;
+    float fz = z - z0;
+    int32_t ix = (int32_t)x0;
+    int32_t iy = (int32_t)y0;
+    int32_t iz = (int32_t)z0;
+
+    float n000 = gradient3(hashCorner3(ix, iy, iz, seed), fx, fy, fz);
+    float n100 = gradient3(hashCorner3(ix + 1, iy, iz, seed), fx - 1.0f, fy, fz);
+    float n010 = gradient3(hashCorner3(ix, iy + 1, iz, seed), fx, fy - 1.0f, fz);
+    float n110 = gradient3(hashCorner3(ix + 1, iy + 1, iz, seed), fx - 1.0f, fy - 1.0f, fz);
+    float n001 = gradient3(hashCorner3(ix, iy, iz + 1, seed), fx, fy, fz - 1.0f);
+    float n101 = gradient3(hashCorner3(ix + 1, iy, iz + 1, seed), fx - 1.0f, fy, fz - 1.0f);
+    float n011 = gradient3(hashCorner3(ix, iy + 1, iz + 1, seed), fx, fy - 1.0f, fz - 1.0f);
+    float n111 = gradient3(hashCorner3(ix + 1, iy + 1, iz + 1, seed), fx - 1.0f, fy - 1.0f, fz - 1.0f);
+
+    float u = fade(fx);
+    float v = fade(fy);
+    float w = fade(fz);
+    float nearZ = lerp(lerp(n000, n100, u), lerp(n010, n110, u), v);
+    float farZ = lerp(lerp(n001, n101, u), lerp(n011, n111, u), v);
+    return lerp(nearZ, farZ, w) * NOISE_SCALE3;
+}
+
+float fractalNoise3(const NoiseSettings& settings, float x, float y, float z) {
+    float sum = 0.0f;
+    float total = 0.0f;
+    float amplitude = 1.0f;
+    float frequency = settings.frequency;
+    for (int octave = 0; octave < settings.octaves; ++octave) {
+        uint32_t seed = settings.seed + (uint32_t)octave * OCTAVE_SEED_STEP;
+        sum = sum + amplitude * gradientNoise3(x * frequency, y * frequency, z * frequency, seed);
+        total = total + amplitude;
+        amplitude = amplitude * settings.gain;
+        frequency = frequency * settings.lacunarity;
+    }
+    return total > 0.0f ? sum / total : 0.0f;
+}
+
+#ifdef NOISE_X86
+// === SSE4.1, four points at a time ===
+
+NOISE_TARGET("sse4.1")
+static inline __m128i hashCorner4(__m128i hx, __m128i hz, __m128i seed) {
+    __m128i h = _mm_xor_si128(_mm_xor_si128(hx, hz), seed);
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+    h = _mm_mullo_epi32(h, _mm_set1_epi32((int)HASH_MIX));
+    return _mm_xor_si128(h, _mm_srli_epi32(h, 12));
+}
+
+NOISE_TARGET("sse4.1")
+static inline __m128 gradient4(__m128i h, __m128 x, __m128 z) {
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(4)), _mm_set1_epi32(4)));
+    __m128 u = _mm_blendv_ps(x, z, swap);
+    __m128 v = _mm_blendv_ps(z, x, swap);
+    __m128 signU = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31));
+    __m128 signV = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30));
+    __m128 a = _mm_xor_ps(u, signU);
+    __m128 b = _mm_xor_ps(_mm_mul_ps(_mm_set1_ps(2.0f), v), signV);
+    return _mm_add_ps(a, b);
+}
+
+NOISE_TARGET("sse4.1")
+static inline __m128 fade4(__m128 t) {
+    __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f));
+    return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+}
+
+NOISE_TARGET("sse4.1")
+static inline __m128 lerp4(__m128 a, __m128 b, __m128 t) {
+    return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+NOISE_TARGET("sse4.1")
+static __m128 gradientNoise4(__m128 x, __m128 z, __m128i seed) {
+    __m128 x0 = _mm_floor_ps(x);
+    __m128 z0 = _mm_floor_ps(z);
+    __m128 fx = _mm_sub_ps(x, x0);
+    __m128 fz = _mm_sub_ps(z, z0);
+    __m128i ix = _mm_cvttps_epi32(x0);
+    __m128i iz = _mm_cvttps_epi32(z0);
+    __m128i one = _mm_set1_epi32(1);
+    __m128i hx0 = _mm_mullo_epi32(ix, _mm_set1_epi32((int)HASH_X));
+    __m128i hx1 = _mm_mullo_epi32(_mm_add_epi32(ix, one), _mm_set1_epi32((int)HASH_X));
+    __m128i hz0 = _mm_mullo_epi32(iz, _mm_set1_epi32((int)HASH_Z));
+    __m128i hz1 = _mm_mullo_epi32(_mm_add_epi32(iz, one), _mm_set1_epi32((int)HASH_Z));
+    __m128 fx1 = _mm_sub_ps(fx, _mm_set1_ps(1.0f));
+    __m128 fz1 = _mm_sub_ps(fz, _mm_set1_ps(1.0f));
+
+    __m128 n00 = gradient4(hashCorner4(hx0, hz0, seed), fx, fz);
+    __m128 n10 = gradient4(hashCorner4(hx1, hz0, seed), fx1, fz);
+    __m128 n01 = gradient4(hashCorner4(hx0, hz1, seed), fx, fz1);
+    __m128 n11 = gradient4(hashCorner4(hx1, hz1, seed), fx1, fz1);
+
+    __m128 u = fade4(fx);
+    __m128 v = fade4(fz);
+    return _mm_mul_ps(lerp4(lerp4(n00, n10, u), lerp4(n01, n11, u), v), _mm_set1_ps(NOISE_SCALE));
+}
+
+NOISE_TARGET("sse4.1")
+static void fractalNoiseSse41(const NoiseSettings& settings, const float* x, const float* z, float* out, int count) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i);
+        __m128 pz = _mm_loadu_ps(z + i);
+        __m128 sum = _mm_setzero_ps();
+        float total = 0.0f;
+        float amplitude = 1.0f;
+        float frequency = settings.frequency;
+        for (int octave = 0; octave < settings.octaves; ++octave) {
+            __m128i seed = _mm_set1_epi32((int)(settings.seed + (uint32_t)octave * OCTAVE_SEED_STEP));
+            __m128 f = _mm_set1_ps(frequency);
+            __m128 n = gradientNoise4(_mm_mul_ps(px, f), _mm_mul_ps(pz, f), seed);
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(amplitude), n));
+            total = total + amplitude;
+            amplitude = amplitude * settings.gain;
+            frequency = frequency * settings.lacunarity;
+        }
+        _mm_storeu_ps(out + i, total > 0.0f ? _mm_div_ps(sum, _mm_set1_ps(total)) : _mm_setzero_ps());
+    }
+    fractalNoiseScalar(settings, x + i, z + i, out + i, count - i);
+}
+
+// === AVX2, eight points at a time ===
+
+NOISE_TARGET("avx2")
+static inline __m256i hashCorner8(__m256i hx, __m256i hz, __m256i seed) {
+    __m256i h = _mm256_xor_si256(_mm256_xor_si256(hx, hz), seed);
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)HASH_MIX));
+    return _mm256_xor_si256(h, _mm256_srli_epi32(h, 12));
+}
+
+NOISE_TARGET("avx2")
+static inline __m256 gradient8(__m256i h, __m256 x, __m256 z) {
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(h, _mm256_set1_epi32(4)), _mm256_set1_epi32(4)));
+    __m256 u = _mm256_blendv_ps(x, z, swap);
+    __m256 v = _mm256_blendv_ps(z, x, swap);
+    __m256 signU = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31));
+    __m256 signV = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30));
+    __m256 a = _mm256_xor_ps(u, signU);
+    __m256 b = _mm256_xor_ps(_mm256_mul_ps(_mm256_set1_ps(2.0f), v), signV);
+    return _mm256_add_ps(a, b);
+}
+
+NOISE_TARGET("avx2")
+static inline __m256 fade8(__m256 t) {
+    __m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f))),
+                                 _mm256_set1_ps(10.0f));
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+}
+
+NOISE_TARGET("avx2")
+static inline __m256 lerp8(__m256 a, __m256 b, __m256 t) {
+    return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+}
+
+NOISE_TARGET("avx2")
+static __m256 gradientNoise8(__m256 x, __m256 z, __m256i seed) {
+    __m256 x0 = _mm256_floor_ps(x);
+    __m256 z0 = _mm256_floor_ps(z);
+    __m256 fx = _mm256_sub_ps(x, x0);
+    __m256 fz = _mm256_sub_ps(z, z0);
+    __m256i ix = _mm256_cvttps_epi32(x0);
+    __m256i iz = _mm256_cvttps_epi32(z0);
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i hx0 = _mm256_mullo_epi32(ix, _mm256_set1_epi32((int)HASH_X));
+    __m256i hx1 = _mm256_mullo_epi32(_mm256_add_epi32(ix, one), _mm256_set1_epi32((int)HASH_X));
+    __m256i hz0 = _mm256_mullo_epi32(iz, _mm256_set1_epi32((int)HASH_Z));
+    __m256i hz1 = _mm256_mullo_epi32(_mm256_add_epi32(iz, one), _mm256_set1_epi32((int)HASH_Z));
+    __m256 fx1 = _mm256_sub_ps(fx, _mm256_set1_ps(1.0f));
+    __m256 fz1 = _mm256_sub_ps(fz, _mm256_set1_ps(1.0f));
+
+    __m256 n00 = gradient8(hashCorner8(hx0, hz0, seed), fx, fz);
+    __m256 n10 = gradient8(hashCorner8(hx1, hz0, seed), fx1, fz);
+    __m256 n01 = gradient8(hashCorner8(hx0, hz1, seed), fx, fz1);
+    __m256 n11 = gradient8(hashCorner8(hx1, hz1, seed), fx1, fz1);
+
+    __m256 u = fade8(fx);
+    __m256 v = fade8(fz);
+    return _mm256_mul_ps(lerp8(lerp8(n00, n10, u), lerp8(n01, n11, u), v), _mm256_set1_ps(NOISE_SCALE));
+}
+
+NOISE_TARGET("avx2")
+static void fractalNoiseAvx2(const NoiseSettings& settings, const float* x, const float* z, float* out, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i);
+        __m256 pz = _mm256_loadu_ps(z + i);
+        __m256 sum = _mm256_setzero_ps();
+        float total = 0.0f;
+        float amplitude = 1.0f;
+        float frequency = settings.frequency;
+        for (int octave = 0; octave < settings.octaves; ++octave) {
+            __m256i seed = _mm256_set1_epi32((int)(settings.seed + (uint32_t)octave * OCTAVE_SEED_STEP));
+            __m256 f = _mm256_set1_ps(frequency);
+            __m256 n = gradientNoise8(_mm256_mul_ps(px, f), _mm256_mul_ps(pz, f), seed);
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(amplitude), n));
+            total = total + amplitude;
+            amplitude = amplitude * settings.gain;
+            frequency = frequency * settings.lacunarity;
+        }
+        _mm256_storeu_ps(out + i, total > 0.0f ? _mm256_div_ps(sum, _mm256_set1_ps(total)) : _mm256_setzero_ps());
+    }
+    fractalNoiseScalar(settings, x + i, z + i, out + i, count - i);
+}
+#endif
+
+// === Dispatch ===
+
+static bool cpuSupports(NoiseBackend backend) {
+#if !defined(NOISE_X86)
+    return backend == NOISE_SCALAR;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    bool avx2 = osSavesAvx && (info[1] & (1 << 5)) != 0;
+    return backend == NOISE_SCALAR || (backend == NOISE_SSE41 && sse41) || (backend == NOISE_AVX2 && avx2);
+#else
+    __builtin_cpu_init();
+    return backend == NOISE_SCALAR || (backend == NOISE_SSE41 && __builtin_cpu_supports("sse4.1")) ||
+           (backend == NOISE_AVX2 && __builtin_cpu_supports("avx2"));
+#endif
+}
+
+bool noiseBackendSupported(NoiseBackend backend) {
+    static const bool supported[NOISE_BACKEND_COUNT] = {
+        cpuSupports(NOISE_SCALAR), cpuSupports(NOISE_SSE41), cpuSupports(NOISE_AVX2)
+    };
+    return backend >= 0 && backend < NOISE_BACKEND_COUNT && supported[backend];
+}
+
+NoiseBackend bestNoiseBackend() {
+    static const NoiseBackend best = noiseBackendSupported(NOISE_AVX2) ? NOISE_AVX2
+                                   : noiseBackendSupported(NOISE_SSE41) ? NOISE_SSE41 : NOISE_SCALAR;
+    return best;
+}
+
+const char* noiseBackendName(NoiseBackend backend) {
+    switch (backend) {
+    case NOISE_SCALAR: return "scalar";
+    case NOISE_SSE41: return "sse4.1";
+    case NOISE_AVX2: return "avx2";
+    default: return "unknown";
+    }
+}
+
+void fractalNoiseBatch(const NoiseSettings& settings, const float* x, const float* z, float* out, int count) {
+    fractalNoiseBatch(settings, x, z, out, count, bestNoiseBackend());
+}
+
+void fractalNoiseBatch(const NoiseSettings& settings, const float* x, const float* z, float* out, int count,
+                       NoiseBackend backend) {
+    if (!noiseBackendSupported(backend))
+        backend = NOISE_SCALAR;
+#ifdef NOISE_X86
+    if (backend == NOISE_AVX2) {
+        fractalNoiseAvx2(settings, x, z, out, count);
+        return;
+    }
+    if (backend == NOISE_SSE41) {
+        fractalNoiseSse41(settings, x, z, out, count);
+        return;
+    }
+#endif
+    fractalNoiseScalar(settings, x, z, out, count);
+}
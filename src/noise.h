@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+// === Gradient noise ===
+// Seeded 2D Perlin noise and fractal sums of it (fBm). Batches are evaluated
+// eight points at a time with AVX2, four with SSE4.1, or one at a time. All
+// three paths run the same float operations in the same order, so they agree
+// bit for bit, and a single lookup can never disagree with a batched fill.
+struct NoiseSettings {
+    uint32_t seed = 1337;
+    int octaves = 5;
+    float frequency = 1.0f / 96.0f;  // first octave, in cycles per block
+    float lacunarity = 2.0f;         // frequency factor per octave
+    float gain = 0.5f;               // amplitude factor per octave
+};
+
+enum NoiseBackend {
+    NOISE_SCALAR,
+    NOISE_SSE41,
+    NOISE_AVX2,
+    NOISE_BACKEND_COUNT
+};
+
+// Widest backend this CPU runs; batches use it unless told otherwise
+NoiseBackend bestNoiseBackend();
+bool noiseBackendSupported(NoiseBackend backend);
+const char* noiseBackendName(NoiseBackend backend);
+
+// Perlin noise with the given seed, within [-1, 1]
+float gradientNoise(float x, float z, uint32_t seed);
+
+// Sum of the octaves, normalised back to [-1, 1]
+float fractalNoise(const NoiseSettings& settings, float x, float z);
+
+// out[i] = fractalNoise(settings, x[i], z[i]) for count points
+void fractalNoiseBatch(const NoiseSettings& settings, const float* x, const float* z, float* out, int count);
+void fractalNoiseBatch(const NoiseSettings& settings, const float* x, const float* z, float* out, int count,
+                       NoiseBackend backend);
+
+// === 3D gradient noise ===
+// The same lattice noise over (x, y, z), for density fields; scalar only.
+
+// Perlin noise with the given seed, within [-1, 1]
+float gradientNoise3(float x, float y, float z, uint32_t seed);
+
+// Sum of the octaves, normalised back to [-1, 1]
+float fractalNoise3(const NoiseSettings& settings, float x, float y, float z);
@@ -0,0 +1,77 @@
+#include "range_allocator.h"
+
+RangeAllocator::RangeAllocator(int capacity) {
+    grow(capacity);
+}
+
+int RangeAllocator::allocate(int count) {
+    if (count <= 0)
+        return -1;
+    for (size_t i = 0; i < freeRanges.size(); ++i) {
+        Range& range = freeRanges[i];
+        if (range.count < count)
+            continue;
+        int start = range.start;
+        range.start += count;
+        range.count -= count;
+        if (range.count == 0)
+            freeRanges.erase(freeRanges.begin() + i);
+        return start;
+    }
+    return -1;
+}
+
+void RangeAllocator::release(int start, int count) {
+    if (count <= 0)
+        return;
+
+    size_t i = 0;
+    while (i < freeRanges.size() && freeRanges[i].start < start)
+        ++i;
+    freeRanges.insert(freeRanges.begin() + i, Range{ start, count });
+
+    // Merge with the following range, then with the preceding one
+    if (i + 1 < freeRanges.size() && freeRanges[i].start + freeRanges[i].count == freeRanges[i + 1].start) {
+        freeRanges[i].count += freeRanges[i + 1].count;
+        freeRanges.erase(freeRanges.begin() + i + 1);
+    }
+    if (i > 0 && freeRanges[i - 1].start + freeRanges[i - 1].count == freeRanges[i].start) {
+        freeRanges[i - 1].count += freeRanges[i].count;
+        freeRanges.erase(freeRanges.begin() + i);
+    }
+}
+
+bool RangeAllocator::reserve(int start, int count) {
+    if (count <= 0)
+        return false;
+    for (size_t i = 0; i < freeRanges.size(); ++i) {
+        Range range = freeRanges[i];
+        if (start < range.start || start + count > range.start + range.count)
+            continue;
+
+        // Split the free range around the reserved part
+        int tail = range.start + range.count - (start + count);
+        freeRanges[i].count = start - range.start;
+        if (tail > 0)
+            freeRanges.insert(freeRanges.begin() + i + 1, Range{ start + count, tail });
+        if (freeRanges[i].count == 0)
+            freeRanges.erase(freeRanges.begin() + i);
+        return true;
+    }
+    return false;
+}
+
+void RangeAllocator::grow(int newCapacity) {
+    if (newCapacity <= totalUnits)
+        return;
+    int oldCapacity = totalUnits;
+    totalUnits = newCapacity;
+    release(oldCapacity, newCapacity - oldCapacity);
+}
+
+int RangeAllocator::freeUnits() const {
+    int total = 0;
+    for (const Range& range : freeRanges)
+        total += range.count;
+    return total;
+}
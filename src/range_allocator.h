@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// First-fit allocator over [0, capacity) units, keeping a sorted free list
+// that merges neighbouring ranges on release so space is reused
+class RangeAllocator {
+public:
+    explicit RangeAllocator(int capacity = 0);
+
+    // Start of a free run of count units, or -1 if none is large enough
+    int allocate(int count);
+    void release(int start, int count);
+
+    // Marks [start, start + count) as used; false unless it was wholly free
+    bool reserve(int start, int count);
+
+    // Adds [capacity, newCapacity) to the free list
+    void grow(int newCapacity);
+
+    int capacity() const { return totalUnits; }
+    int freeUnits() const;
+
+private:
+    struct Range {
+        int start, count;
+    };
+
+    std::vector<Range> freeRanges;
+    int totalUnits = 0;
+};
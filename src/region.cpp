@@ -0,0 +1,377 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <type_traits>
+#include "compress.h"
+#include "region.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+const int TABLE_SECTORS = (REGION_TABLE_ENTRIES * 8 + REGION_SECTOR_BYTES - 1) / REGION_SECTOR_BYTES;
+
+// Chunk y plus the largest section BlockStorage::write produces: a palette
+// entry for every block and 16-bit indices
+const size_t MAX_STORED_SECTION_BYTES = 4 + 3 + CHUNK_VOLUME * sizeof(int32_t) + CHUNK_VOLUME * 2;
+
+static int sectorsFor(size_t bytes) {
+    return (int)((bytes + REGION_SECTOR_BYTES - 1) / REGION_SECTOR_BYTES);
+}
+
+RegionFile::~RegionFile() {
+    close();
+}
+
+bool RegionFile::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "r+b");
+    if (!file) {
+        // New region: an all-empty table
+        file = std::fopen(path.c_str(), "w+b");
+        if (!file)
+            return false;
+        std::vector<unsigned char> header(TABLE_SECTORS * REGION_SECTOR_BYTES, 0);
+        std::fwrite(header.data(), 1, header.size(), file);
+        std::fflush(file);
+    }
+
+    std::fseek(file, 0, SEEK_END);
+    long length = std::ftell(file);
+    int fileSectors = (int)(length / REGION_SECTOR_BYTES);
+    std::fseek(file, 0, SEEK_SET);
+    if (fileSectors < TABLE_SECTORS || std::fread(table, sizeof(Entry), REGION_TABLE_ENTRIES, file) != REGION_TABLE_ENTRIES) {
+        close();
+        return false;
+    }
+    fileBytes = (size_t)fileSectors * REGION_SECTOR_BYTES;
+
+    // Rebuild the free sectors from the table, dropping entries that point
+    // outside the file or overlap an earlier one
+    sectors = RangeAllocator(fileSectors);
+    sectors.reserve(0, TABLE_SECTORS);
+    for (Entry& entry : table) {
+        if (entry.byteCount == 0)
+            continue;
+        if (!sectors.reserve((int)entry.firstSector, sectorsFor(entry.byteCount)))
+            entry = Entry{ 0, 0 };
+    }
+    mappingStale = true;
+    return true;
+}
+
+void RegionFile::close() {
+    unmap();
+    if (file)
+        std::fclose(file);
+    file = nullptr;
+    fileBytes = 0;
+}
+
+bool RegionFile::map() {
+    unmap();
+#ifdef _WIN32
+    HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+        return false;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+    mappingHandle = mapping;
+#else
+    void* view = mmap(nullptr, fileBytes, PROT_READ, MAP_SHARED, fileno(file), 0);
+    if (view == MAP_FAILED)
+        return false;
+#endif
+    mapped = (const unsigned char*)view;
+    mappedBytes = fileBytes;
+    mappingStale = false;
+    return true;
+}
+
+void RegionFile::unmap() {
+    if (!mapped)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(mapped);
+    CloseHandle((HANDLE)mappingHandle);
+    mappingHandle = nullptr;
+#else
+    munmap((void*)mapped, mappedBytes);
+#endif
+    mapped = nullptr;
+    mappedBytes = 0;
+}
+
+const unsigned char* RegionFile::readColumn(int localX, int localZ, size_t& size) {
+    if (!file)
+        return nullptr;
+    const Entry& entry = table[localX * REGION_COLUMNS + localZ];
+    if (entry.byteCount == 0)
+        return nullptr;
+    if (mappingStale && !map())
+        return nullptr;
+
+    size_t offset = (size_t)entry.firstSector * REGION_SECTOR_BYTES;
+    if (offset + entry.byteCount > mappedBytes)
+        return nullptr;
+    size = entry.byteCount;
+    return mapped + offset;
+}
+
+bool RegionFile::writeColumn(int localX, int localZ, const unsigned char* data, size_t size) {
+    if (!file || size == 0)
+        return false;
+
+    int count = sectorsFor(size);
+    int first = sectors.allocate(count);
+    if (first < 0) {
+        sectors.grow(sectors.capacity() + count);
+        first = sectors.allocate(count);
+    }
+
+    // Data first, padded to whole sectors so the file stays sector aligned
+    static const unsigned char padding[REGION_SECTOR_BYTES] = {};
+    std::fseek(file, (long)first * REGION_SECTOR_BYTES, SEEK_SET);
+    std::fwrite(data, 1, size, file);
+    std::fwrite(padding, 1, (size_t)count * REGION_SECTOR_BYTES - size, file);
+
+    // Then point the table entry at it and give the old sectors back
+    int entryIndex = localX * REGION_COLUMNS + localZ;
+    Entry old = table[entryIndex];
+    table[entryIndex] = Entry{ (uint32_t)first, (uint32_t)size };
+    std::fseek(file, (long)(entryIndex * sizeof(Entry)), SEEK_SET);
+    std::fwrite(&table[entryIndex], sizeof(Entry), 1, file);
+    bool ok = std::fflush(file) == 0;
+    if (old.byteCount > 0)
+        sectors.release((int)old.firstSector, sectorsFor(old.byteCount));
+
+    fileBytes = std::max(fileBytes, (size_t)(first + count) * REGION_SECTOR_BYTES);
+    mappingStale = true;
+    return ok;
+}
+
+bool syncFile(std::FILE* file) {
+    if (!file || std::fflush(file) != 0)
+        return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool RegionFile::sync() {
+    return syncFile(file);
+}
+
+RegionStore::RegionStore(const std::string& directory) : directory(directory) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+}
+
+RegionStore::OpenRegion* RegionStore::region(int regionX, int regionZ) {
+    uint64_t key = packChunkKey(regionX, 0, regionZ);
+    auto found = regions.find(key);
+    if (found != regions.end())
+        return &found->second;
+
+    // Few regions are ever in use at once, so just close the synced ones past
+    // the limit; one with unsynced writes is kept for the next sync()
+    if (regions.size() >= MAX_OPEN_REGIONS) {
+        for (auto it = regions.begin(); it != regions.end();) {
+            if (it->second.writes == it->second.syncedWrites)
+                it = regions.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    std::shared_ptr<RegionFile> file = std::make_shared<RegionFile>();
+    std::string path = directory + "/r." + std::to_string(regionX) + "." + std::to_string(regionZ) + ".region";
+    if (!file->open(path)) {
+        std::cerr << "Failed to open region file: " << path << "\n";
+        return nullptr;
+    }
+    OpenRegion& opened = regions[key];
+    opened.file = std::move(file);
+    return &opened;
+}
+
+// Reads one section saved in the given layout into the build's layout
+template <typename StoredLayout>
+static size_t readSectionAs(const unsigned char* data, size_t size, BlockStorage& blocks) {
+    if constexpr (std::is_same<StoredLayout, BlockStorage::BlockLayout>::value)
+        return blocks.read(data, size);
+
+    BasicBlockStorage<StoredLayout> stored;
+    size_t used = stored.read(data, size);
+    if (used == 0)
+        return 0;
+    if (stored.isUniform()) {
+        blocks.reset(stored.uniformBlock());
+        return used;
+    }
+    thread_local std::vector<int> saved(CHUNK_VOLUME), reordered(CHUNK_VOLUME);
+    stored.unpack(saved.data());
+    for (int i = 0; i < CHUNK_VOLUME; ++i) {
+        int x, y, z;
+        StoredLayout::coords(i, x, y, z);
+        reordered[BlockStorage::index(x, y, z)] = saved[i];
+    }
+    blocks.pack(reordered.data());
+    return used;
+}
+
+static size_t readSection(int layoutId, const unsigned char* data, size_t size, BlockStorage& blocks) {
+    switch (layoutId) {
+    case LayoutXYZ::id: return readSectionAs<LayoutXYZ>(data, size, blocks);
+    case LayoutXZY::id: return readSectionAs<LayoutXZY>(data, size, blocks);
+    case LayoutYZX::id: return readSectionAs<LayoutYZX>(data, size, blocks);
+    case LayoutMorton::id: return readSectionAs<LayoutMorton>(data, size, blocks);
+    default: return 0;
+    }
+}
+
+bool RegionStore::loadColumn(World& world, int chunkX, int chunkZ, std::vector<int>& added) {
+    std::lock_guard<std::mutex> guard(lock);
+    OpenRegion* slot = region(floorDiv(chunkX, REGION_COLUMNS), floorDiv(chunkZ, REGION_COLUMNS));
+    if (!slot)
+        return false;
+    size_t size = 0;
+    const unsigned char* stored = slot->file->readColumn(floorMod(chunkX, REGION_COLUMNS), floorMod(chunkZ, REGION_COLUMNS), size);
+    if (!stored || size < 5)
+        return false;
+    int layoutId;
+    size_t headerSize;
+    if (stored[0] == COLUMN_LZ) {
+        layoutId = LayoutXYZ::id;
+        headerSize = 5;
+    }
+    else if (stored[0] == COLUMN_LZ_LAYOUT && size >= 6) {
+        layoutId = stored[1];
+        headerSize = 6;
+    }
+    else {
+        return false;
+    }
+
+    // The decoded size comes straight from disk, so it is checked against the
+    // section count before anything is allocated for it
+    uint32_t decodedSize;
+    std::memcpy(&decodedSize, stored + headerSize - 4, 4);
+    unsigned char countBytes[2];
+    if (decodedSize < 2 || !lzDecompressPrefix(stored + headerSize, size - headerSize, countBytes, 2))
+        return false;
+    uint16_t sectionCount;
+    std::memcpy(&sectionCount, countBytes, 2);
+    if (decodedSize > 2 + sectionCount * MAX_STORED_SECTION_BYTES)
+        return false;
+
+    scratch.resize(decodedSize);
+    if (!lzDecompress(stored + headerSize, size - headerSize, scratch.data(), decodedSize))
+        return false;
+    const unsigned char* data = scratch.data();
+    size = decodedSize;
+    size_t offset = 2;
+    for (int s = 0; s < sectionCount; ++s) {
+        if (offset + 4 > size)
+            break;
+        int32_t chunkY;
+        std::memcpy(&chunkY, data + offset, 4);
+        offset += 4;
+
+        BlockStorage blocks;
+        size_t used = readSection(layoutId, data + offset, size - offset, blocks);
+        if (used == 0)
+            break;  // the rest of a damaged column is regenerated
+        offset += used;
+        if (world.findChunk(chunkX, chunkY, chunkZ) >= 0)
+            continue;
+
+        int index = world.addChunk(chunkX, chunkY, chunkZ);
+        Chunk& chunk = world.chunk(index);
+        chunk.replaceBlocks(std::move(blocks));
+        chunk.dirty = true;
+        chunk.unsaved = false;
+        added.push_back(index);
+    }
+    return true;
+}
+
+bool RegionStore::hasColumn(int chunkX, int chunkZ) {
+    std::lock_guard<std::mutex> guard(lock);
+    OpenRegion* slot = region(floorDiv(chunkX, REGION_COLUMNS), floorDiv(chunkZ, REGION_COLUMNS));
+    return slot && slot->file->hasColumn(floorMod(chunkX, REGION_COLUMNS), floorMod(chunkZ, REGION_COLUMNS));
+}
+
+bool RegionStore::writeColumn(int chunkX, int chunkZ, const unsigned char* data, size_t size) {
+    std::lock_guard<std::mutex> guard(lock);
+    OpenRegion* slot = region(floorDiv(chunkX, REGION_COLUMNS), floorDiv(chunkZ, REGION_COLUMNS));
+    if (!slot)
+        return false;
+    ++slot->writes;
+    return slot->file->writeColumn(floorMod(chunkX, REGION_COLUMNS), floorMod(chunkZ, REGION_COLUMNS), data, size);
+}
+
+bool RegionStore::sync() {
+    struct Pending {
+        uint64_t key;
+        std::shared_ptr<RegionFile> file;
+        uint64_t writes;
+    };
+    std::vector<Pending> pending;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto& entry : regions) {
+            if (entry.second.writes != entry.second.syncedWrites)
+                pending.push_back(Pending{ entry.first, entry.second.file, entry.second.writes });
+        }
+    }
+
+    // The fsyncs take the longest; unsynced regions are never closed meanwhile
+    bool ok = true;
+    for (Pending& region : pending) {
+        if (!region.file->sync()) {
+            ok = false;
+            continue;
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        auto found = regions.find(region.key);
+        if (found != regions.end() && found->second.file == region.file)
+            found->second.syncedWrites = std::max(found->second.syncedWrites, region.writes);
+    }
+    return ok;
+}
+
+size_t encodeColumn(const std::vector<ColumnSection>& sections, std::vector<unsigned char>& out) {
+    thread_local std::vector<unsigned char> raw;
+    raw.assign(2, 0);
+    uint16_t sectionCount = (uint16_t)sections.size();
+    std::memcpy(raw.data(), &sectionCount, 2);
+    for (const ColumnSection& section : sections) {
+        int32_t chunkY = section.chunkY;
+        size_t at = raw.size();
+        raw.resize(at + 4);
+        std::memcpy(raw.data() + at, &chunkY, 4);
+        section.blocks->write(raw);
+    }
+
+    uint32_t decodedSize = (uint32_t)raw.size();
+    size_t at = out.size();
+    out.resize(at + 6);
+    out[at] = COLUMN_LZ_LAYOUT;
+    out[at + 1] = (unsigned char)BlockStorage::BlockLayout::id;
+    std::memcpy(out.data() + at + 2, &decodedSize, 4);
+    lzCompress(raw.data(), raw.size(), out);
+    return raw.size();
+}
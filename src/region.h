@@ -0,0 +1,127 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "range_allocator.h"
+#include "world.h"
+
+// === Region files ===
+// Chunk columns are saved 32x32 to a file: an offset table with one entry per
+// column (first sector, byte length) followed by 4 KiB sectors. Reads come
+// straight out of a memory mapping of the file. Writes go to sectors handed
+// out by a RangeAllocator and only then repoint the table entry, so a crash
+// mid-write leaves the previous copy of the column intact.
+const int REGION_COLUMNS = 32;
+const int REGION_SECTOR_BYTES = 4096;
+const int REGION_TABLE_ENTRIES = REGION_COLUMNS * REGION_COLUMNS;
+
+// fflush followed by fsync / _commit
+bool syncFile(std::FILE* file);
+
+class RegionFile {
+public:
+    RegionFile() = default;
+    ~RegionFile();
+    RegionFile(const RegionFile&) = delete;
+    RegionFile& operator=(const RegionFile&) = delete;
+
+    // Opens the file, creating an empty region if it does not exist
+    bool open(const std::string& path);
+    void close();
+
+    // Bytes saved for local column (x, z), or null if it was never written.
+    // Points into the mapping and stays valid until the next write.
+    const unsigned char* readColumn(int localX, int localZ, size_t& size);
+    bool writeColumn(int localX, int localZ, const unsigned char* data, size_t size);
+    // From the offset table alone
+    bool hasColumn(int localX, int localZ) const { return file && table[localX * REGION_COLUMNS + localZ].byteCount > 0; }
+
+    // Forces written columns to disk
+    bool sync();
+
+    size_t sizeInBytes() const { return fileBytes; }
+
+private:
+    struct Entry {
+        uint32_t firstSector;
+        uint32_t byteCount;  // 0 for a column never written
+    };
+
+    bool map();
+    void unmap();
+
+    std::FILE* file = nullptr;
+    Entry table[REGION_TABLE_ENTRIES];
+    RangeAllocator sectors;
+    size_t fileBytes = 0;
+
+    const unsigned char* mapped = nullptr;
+    size_t mappedBytes = 0;
+    bool mappingStale = true;  // remapped lazily on the first read after a write
+#ifdef _WIN32
+    void* mappingHandle = nullptr;
+#endif
+};
+
+// One section of a column on its way to disk, shared with the chunk until
+// the chunk is next edited
+struct ColumnSection {
+    int chunkY;
+    std::shared_ptr<const BlockStorage> blocks;
+};
+
+// A column is stored as a codec byte, the block layout id and its decoded size,
+// then the section count followed by (chunk y, BlockStorage bytes) per section,
+// LZ compressed. COLUMN_LZ columns predate the layout byte and are in XYZ
+// order. Sections saved under another CHUNK_LAYOUT are reordered on load.
+const unsigned char COLUMN_RAW = 0;
+const unsigned char COLUMN_LZ = 1;         // [codec][u32 decoded size]
+const unsigned char COLUMN_LZ_LAYOUT = 2;  // [codec][layout id][u32 decoded size]
+
+// Appends the stored form of a column to out and returns its decoded size
+size_t encodeColumn(const std::vector<ColumnSection>& sections, std::vector<unsigned char>& out);
+
+// Region files of one world directory, opened on demand. Safe to call from
+// several threads; each call holds the store's lock, except that sync() runs
+// the fsyncs outside it so a load is never stuck behind the disk. Regions with
+// writes not yet synced stay open past the limit, so sync() covers every write.
+class RegionStore {
+public:
+    explicit RegionStore(const std::string& directory);
+
+    const std::string& path() const { return directory; }
+
+    // Adds the saved sections of column (chunkX, chunkZ) that are not already
+    // loaded and appends their indices; false if the column was never saved
+    bool loadColumn(World& world, int chunkX, int chunkZ, std::vector<int>& added);
+    // True if the column was ever saved; reads only the region's offset table
+    bool hasColumn(int chunkX, int chunkZ);
+
+    // Stores an encodeColumn() payload for the column
+    bool writeColumn(int chunkX, int chunkZ, const unsigned char* data, size_t size);
+
+    // Forces every region written since its last sync to disk; false if any
+    // failed, and those are retried by the next call
+    bool sync();
+
+private:
+    static const int MAX_OPEN_REGIONS = 16;
+
+    struct OpenRegion {
+        std::shared_ptr<RegionFile> file;  // shared so sync() can use it without the lock
+        uint64_t writes = 0;               // columns written since it was opened
+        uint64_t syncedWrites = 0;         // of those, known to be on disk
+    };
+
+    OpenRegion* region(int regionX, int regionZ);
+
+    std::mutex lock;
+    std::string directory;
+    std::unordered_map<uint64_t, OpenRegion> regions;
+    std::vector<unsigned char> scratch;
+};
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include "streaming.h"
+#include "mesher.h"
+
+static int ringOf(const glm::ivec2& column, const glm::ivec2& centre) {
+    return std::max(std::abs(column.x - centre.x), std::abs(column.y - centre.y));
+}
+
+static uint64_t columnKey(const glm::ivec2& column) {
+    return packChunkKey(column.x, 0, column.y);
+}
+
+// Half the edge of the square of columns within radius of the centre column, in blocks
+static float squareReach(int radius) {
+    return (radius + 0.5f) * CHUNK_SIZE;
+}
+
+float StreamingSettings::viewDistance() const {
+    // The loaded square seen from the far side of the camera's column on both
+    // axes, and the whole height of a column plus a chunk for a camera above the top
+    float across = squareReach(loadRadius) + 0.5f * CHUNK_SIZE;
+    float height = (maxChunkY - minChunkY + 2) * (float)CHUNK_SIZE;
+    return glm::length(glm::vec3(across, height, across));
+}
+
+ChunkStreamer::ChunkStreamer(const StreamingSettings& settings, WorldSaver* saver, JobSystem* jobs)
+    : settings(settings), saver(saver), jobs(jobs), pipeline(settings.minChunkY, settings.maxChunkY, jobs) {
+}
+
+void ChunkStreamer::update(World& world, const glm::vec3& cameraPos) {
+    update(world, cameraPos, settings.budgetMs);
+}
+
+void ChunkStreamer::update(World& world, const glm::vec3& cameraPos, double budgetMs) {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    unloaded.clear();
+    loaded.clear();
+
+    // Blocks are centred on their coordinates, same as the camera chunk lookup
+    glm::ivec2 column(floorDiv((int)std::floor(cameraPos.x + 0.5f), CHUNK_SIZE),
+                      floorDiv((int)std::floor(cameraPos.z + 0.5f), CHUNK_SIZE));
+    if (!centred || column != centre)
+        recentre(world, column);
+    if (jobs)
+        addGenerated(world);
+
+    size_t maxInFlight = jobs ? (size_t)(settings.columnsInFlight * jobs->workerCount()) : 0;
+    bool progressed = false;
+    while (nextPending < pending.size()) {
+        glm::ivec2 next = pending[nextPending];
+
+        // Checked before each column but never before the first, so every update makes progress
+        std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        if (progressed && elapsed.count() >= budgetMs)
+            break;
+        if (jobs && generating.size() >= maxInFlight)
+            break;
+        if (generating.count(columnKey(next))) {
+            ++nextPending;  // still on its way from before the last recentre
+            continue;
+        }
+
+        // Saved sections first; anything still missing is generated
+        size_t firstNew = loaded.size();
+        if (saver)
+            saver->loadColumn(world, next.x, next.y, loaded);
+        std::vector<int>& missing = missingChunkYs;
+        missing.clear();
+        for (int y = settings.minChunkY; y <= settings.maxChunkY; ++y)
+            if (world.findChunk(next.x, y, next.y) < 0)
+                missing.push_back(y);
+        if (!missing.empty()) {
+            // The whole column is generated; addGenerated() keeps the saved sections
+            pipeline.request(next);
+            generating[columnKey(next)] = next;
+            if (!jobs)
+                addGenerated(world);
+        }
+        for (size_t i = firstNew; i < loaded.size(); ++i)
+            markNeighboursDirty(world, world.chunkCoord(loaded[i]));
+        ++nextPending;
+        progressed = true;
+    }
+
+    // The nearest column still missing bounds the square that is complete
+    int nearestMissing = settings.loadRadius + 1;
+    if (nextPending < pending.size())
+        nearestMissing = ringOf(pending[nextPending], centre);
+    for (const auto& entry : generating)
+        nearestMissing = std::min(nearestMissing, ringOf(entry.second, centre));
+    completeRings = nearestMissing - 1;
+
+    // Starts the stages of the columns requested above
+    if (jobs)
+        pipeline.update();
+}
+
+void ChunkStreamer::loadAll(World& world, const glm::vec3& cameraPos) {
+    std::vector<int> allUnloaded, allLoaded;
+    for (;;) {
+        update(world, cameraPos, 1.0e9);
+        allUnloaded.insert(allUnloaded.end(), unloaded.begin(), unloaded.end());
+        allLoaded.insert(allLoaded.end(), loaded.begin(), loaded.end());
+        if (pendingCount() == 0)
+            break;
+        if (!generating.empty())
+            pipeline.waitForProgress();
+    }
+    unloaded.swap(allUnloaded);
+    loaded.swap(allLoaded);
+}
+
+// Finished columns join the world here, on the thread that owns it
+void ChunkStreamer::addGenerated(World& world) {
+    pipeline.update();
+    finishedColumns.clear();
+    pipeline.takeFinished(finishedColumns);
+    for (FinishedColumn& result : finishedColumns) {
+        generating.erase(columnKey(result.column));
+        if (ringOf(result.column, centre) > settings.unloadRadius)
+            continue;  // the camera moved away while it was generated
+
+        size_t firstNew = loaded.size();
+        for (size_t i = 0; i < result.sections.size(); ++i) {
+            int chunkY = settings.minChunkY + (int)i;
+            if (world.findChunk(result.column.x, chunkY, result.column.y) >= 0)
+                continue;
+            int index = world.addChunk(result.column.x, chunkY, result.column.y);
+            Chunk& chunk = world.chunk(index);
+            chunk.replaceBlocks(std::move(result.sections[i]));
+            chunk.dirty = true;
+            loaded.push_back(index);
+        }
+        for (size_t i = firstNew; i < loaded.size(); ++i)
+            markNeighboursDirty(world, world.chunkCoord(loaded[i]));
+    }
+}
+
+// Frees chunks beyond the unload radius and queues the load square around the
+// new centre column, ring by ring and by true distance within a ring
+void ChunkStreamer::recentre(World& world, const glm::ivec2& newCentre) {
+    centre = newCentre;
+    centred = true;
+
+    for (int i = 0; i < world.chunkCapacity(); ++i) {
+        if (!world.isLoaded(i))
+            continue;
+        glm::ivec3 coord = world.chunkCoord(i);
+        if (ringOf(glm::ivec2(coord.x, coord.z), centre) > settings.unloadRadius)
+            unloaded.push_back(i);
+    }
+
+    // Whole columns are snapshotted before any of their sections is freed
+    if (saver) {
+        std::vector<glm::ivec2> columns;
+        for (int index : unloaded)
+            columns.push_back(glm::ivec2(world.chunkCoord(index).x, world.chunkCoord(index).z));
+        saver->submit(world, columns);
+    }
+    for (int index : unloaded) {
+        glm::ivec3 coord = world.chunkCoord(index);
+        world.removeChunk(index);
+        markNeighboursDirty(world, coord);
+    }
+
+    // Requests past the unload radius would be dropped when they finish anyway
+    for (auto it = generating.begin(); it != generating.end();) {
+        if (ringOf(it->second, centre) > settings.unloadRadius)
+            it = generating.erase(it);
+        else
+            ++it;
+    }
+    pipeline.retain(centre, settings.unloadRadius);
+
+    pending.clear();
+    nextPending = 0;
+    for (int x = -settings.loadRadius; x <= settings.loadRadius; ++x)
+        for (int z = -settings.loadRadius; z <= settings.loadRadius; ++z)
+            pending.push_back(centre + glm::ivec2(x, z));
+    glm::ivec2 c = centre;
+    std::sort(pending.begin(), pending.end(), [c](const glm::ivec2& a, const glm::ivec2& b) {
+        int ringA = ringOf(a, c), ringB = ringOf(b, c);
+        if (ringA != ringB)
+            return ringA < ringB;
+        glm::ivec2 da = a - c, db = b - c;
+        return da.x * da.x + da.y * da.y < db.x * db.x + db.y * db.y;
+    });
+}
+
+// Border faces towards a chunk that just appeared or disappeared are stale
+void ChunkStreamer::markNeighboursDirty(World& world, const glm::ivec3& coord) {
+    for (int f = 0; f < FACE_COUNT; ++f) {
+        Chunk* neighbour = world.getChunk(coord.x + faceNormals[f][0], coord.y + faceNormals[f][1], coord.z + faceNormals[f][2]);
+        if (neighbour)
+            neighbour->dirty = true;
+    }
+}
+
+glm::vec4 ChunkStreamer::completeArea() const {
+    if (completeRings < 0)
+        return glm::vec4(0.0f);
+    // Blocks are centred on their coordinates, so the square is offset by half a block
+    float reach = squareReach(completeRings);
+    glm::vec2 middle = (glm::vec2(centre) + 0.5f) * (float)CHUNK_SIZE - 0.5f;
+    return glm::vec4(middle.x - reach, middle.y - reach, middle.x + reach, middle.y + reach);
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "autosave.h"
+#include "jobs.h"
+#include "world.h"
+#include "worldgen.h"
+
+// === Chunk streaming ===
+// Keeps a square of chunk columns loaded around the camera. Missing chunks are
+// generated ring by ring, nearest first, under a per-update time budget; chunks
+// past the unload radius are freed. The gap between the two radii stops a
+// player pacing along a border from loading and freeing the same chunks.
+// With a WorldSaver, columns are read back from disk when they were saved
+// before, and changed columns are queued for saving before they are freed.
+// Missing columns go through the staged WorldGenPipeline. With a JobSystem its
+// stages run on the workers and finished columns join the world in a later
+// update; the budget then only covers loading and adding. A column that went
+// out of range while it was being generated is dropped.
+struct StreamingSettings {
+    int loadRadius = 8;     // columns (Chebyshev distance) kept loaded around the camera column
+    int unloadRadius = 10;  // columns further than this are freed; keep it above loadRadius
+    int minChunkY = -1;     // vertical range of every column, in chunks
+    int maxChunkY = 1;
+    double budgetMs = 4.0;  // generation time per update
+    int columnsInFlight = 4;  // per job worker, generated columns not added yet
+
+    // Furthest a block of the loaded columns can be from a camera in the centre
+    // column, so the far plane for chunks never clips one inside the load radius
+    float viewDistance() const;
+};
+
+class ChunkStreamer {
+public:
+    explicit ChunkStreamer(const StreamingSettings& settings = StreamingSettings(), WorldSaver* saver = nullptr,
+                           JobSystem* jobs = nullptr);
+    ChunkStreamer(const ChunkStreamer&) = delete;
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+    // Frees far chunks, then generates missing ones until the budget is spent
+    void update(World& world, const glm::vec3& cameraPos);
+    void update(World& world, const glm::vec3& cameraPos, double budgetMs);
+    // Updates until every column in the load radius is there, e.g. at start-up.
+    // The chunk lists then cover all of those updates.
+    void loadAll(World& world, const glm::vec3& cameraPos);
+
+    // Indices removed and added by the last update, for per-chunk side tables.
+    // A removed index can come back as an added one, so handle removals first.
+    const std::vector<int>& unloadedChunks() const { return unloaded; }
+    const std::vector<int>& loadedChunks() const { return loaded; }
+
+    // Every column within this Chebyshev radius of centreColumn() is loaded; -1 if none
+    int completeRadius() const { return completeRings; }
+    // (minX, minZ, maxX, maxZ) in world blocks of the columns within
+    // completeRadius(), or all zero if none. It is measured like
+    // StreamingSettings::viewDistance() and never passes the load radius, so
+    // chunks are drawn all the way out to where the horizon takes over.
+    glm::vec4 completeArea() const;
+    glm::ivec2 centreColumn() const { return centre; }
+    int pendingCount() const { return (int)(pending.size() - nextPending + generating.size()); }
+
+    const StreamingSettings& streamingSettings() const { return settings; }
+    const WorldGenPipeline& generator() const { return pipeline; }
+
+private:
+    void recentre(World& world, const glm::ivec2& newCentre);
+    void addGenerated(World& world);
+    void markNeighboursDirty(World& world, const glm::ivec3& coord);
+
+    StreamingSettings settings;
+    WorldSaver* saver;
+    JobSystem* jobs;
+    glm::ivec2 centre = glm::ivec2(0);
+    bool centred = false;
+
+    // Columns still to generate, sorted nearest first; nextPending is the cursor
+    std::vector<glm::ivec2> pending;
+    size_t nextPending = 0;
+    int completeRings = -1;
+
+    WorldGenPipeline pipeline;
+    std::unordered_map<uint64_t, glm::ivec2> generating;  // requested from the pipeline, by column key
+    std::vector<FinishedColumn> finishedColumns;          // scratch for addGenerated()
+
+    std::vector<int> unloaded;
+    std::vector<int> loaded;
+    std::vector<int> missingChunkYs;  // scratch for update()
+};
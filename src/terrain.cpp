@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+#include "noise.h"
+#include "terrain.h"
+
+static const NoiseSettings terrainNoise;
+
+static NoiseSettings makeNoise(uint32_t seed, int octaves, float frequency) {
+    NoiseSettings settings;
+    settings.seed = seed;
+    settings.octaves = octaves;
+    settings.frequency = frequency;
+    return settings;
+}
+
+// Bends the surface into overhangs, and picks out cave pockets
+static const NoiseSettings shapeNoise = makeNoise(terrainNoise.seed + 1, 3, 1.0f / 48.0f);
+static const NoiseSettings caveNoise = makeNoise(terrainNoise.seed + 2, 2, 1.0f / 32.0f);
+
+const float DENSITY_FALLOFF = 8.0f;  // blocks per unit of density away from the surface
+const float SHAPE_STRENGTH = 1.0f;   // so overhangs move the surface by up to DENSITY_FALLOFF blocks
+const float CAVE_THRESHOLD = 0.25f;  // cave noise above this is hollow
+const float CAVE_SHARPNESS = 4.0f;
+
+static std::atomic<TerrainGenerator> currentGenerator{ TERRAIN_HEIGHTMAP };
+
+static int heightFromNoise(float noise) {
+    return TERRAIN_BASE_HEIGHT + (int)std::floor(noise * TERRAIN_AMPLITUDE);
+}
+
+static float surfaceFromNoise(float noise) {
+    return (float)TERRAIN_BASE_HEIGHT + noise * TERRAIN_AMPLITUDE;
+}
+
+// Terrain noise for a grid of columns, laid out like getHeights
+static void columnNoise(int originX, int originZ, int step, int sizeX, int sizeZ, float* out) {
+    int count = sizeX * sizeZ;
+    thread_local std::vector<float> xs, zs;
+    xs.resize(count);
+    zs.resize(count);
+    for (int i = 0; i < sizeX; ++i) {
+        for (int j = 0; j < sizeZ; ++j) {
+            xs[i * sizeZ + j] = (float)(originX + i * step);
+            zs[i * sizeZ + j] = (float)(originZ + j * step);
+        }
+    }
+    fractalNoiseBatch(terrainNoise, xs.data(), zs.data(), out, count);
+}
+
+int getHeight(int x, int z) {
+    return heightFromNoise(fractalNoise(terrainNoise, (float)x, (float)z));
+}
+
+void getHeights(int originX, int originZ, int step, int sizeX, int sizeZ, int* out) {
+    int count = sizeX * sizeZ;
+    thread_local std::vector<float> noise;
+    noise.resize(count);
+    columnNoise(originX, originZ, step, sizeX, sizeZ, noise.data());
+    for (int i = 0; i < count; ++i)
+        out[i] = heightFromNoise(noise[i]);
+}
+
+// Ground and caves are separate fields; a block is solid where both are positive
+static float shapeDensity(float x, float y, float z, float surface) {
+    return (surface - y) / DENSITY_FALLOFF + SHAPE_STRENGTH * fractalNoise3(shapeNoise, x, y, z);
+}
+
+static float caveDensity(float x, float y, float z) {
+    return (CAVE_THRESHOLD - fractalNoise3(caveNoise, x, y, z)) * CAVE_SHARPNESS;
+}
+
+float terrainDensity(int x, int y, int z) {
+    float surface = surfaceFromNoise(fractalNoise(terrainNoise, (float)x, (float)z));
+    return std::min(shapeDensity((float)x, (float)y, (float)z, surface), caveDensity((float)x, (float)y, (float)z));
+}
+
+void setTerrainGenerator(TerrainGenerator generator) {
+    currentGenerator.store(generator, std::memory_order_relaxed);
+}
+
+TerrainGenerator terrainGenerator() {
+    return currentGenerator.load(std::memory_order_relaxed);
+}
+
+static void generateHeightmap(BlockStorage& blocks, int chunkX, int chunkY, int chunkZ) {
+    int heights[CHUNK_SIZE][CHUNK_SIZE];
+    getHeights(chunkX * CHUNK_SIZE, chunkZ * CHUNK_SIZE, 1, CHUNK_SIZE, CHUNK_SIZE, &heights[0][0]);
+    int minHeight = heights[0][0], maxHeight = heights[0][0];
+    for (int x = 0; x < CHUNK_SIZE; ++x) {
+        for (int z = 0; z < CHUNK_SIZE; ++z) {
+            minHeight = std::min(minHeight, heights[x][z]);
+            maxHeight = std::max(maxHeight, heights[x][z]);
+        }
+    }
+
+    // Sections entirely above or below the surface stay single-valued
+    int bottomY = chunkY * CHUNK_SIZE;
+    int topY = bottomY + CHUNK_SIZE - 1;
+    if (bottomY > maxHeight || topY <= minHeight) {
+        blocks.reset(bottomY > maxHeight ? BLOCK_AIR : BLOCK_STONE);
+        return;
+    }
+
+    int dense[CHUNK_VOLUME];
+    for (int x = 0; x < CHUNK_SIZE; ++x) {
+        for (int z = 0; z < CHUNK_SIZE; ++z) {
+            int height = heights[x][z];
+
+            for (int y = 0; y < CHUNK_SIZE; ++y) {
+                int worldY = bottomY + y;
+
+                if (worldY <= height) {
+                    dense[BlockStorage::index(x, y, z)] = BLOCK_STONE;
+                }
+                else {
+                    dense[BlockStorage::index(x, y, z)] = BLOCK_AIR;
+                }
+            }
+        }
+    }
+    blocks.pack(dense);
+}
+
+static float lerp(float a, float b, float t) {
+    return a + t * (b - a);
+}
+
+const int LATTICE_XZ = CHUNK_SIZE / DENSITY_CELL_XZ + 1;
+const int LATTICE_Y = CHUNK_SIZE / DENSITY_CELL_Y + 1;
+typedef float DensityLattice[LATTICE_XZ][LATTICE_Y][LATTICE_XZ];
+
+// Fills the lattice corners of one chunk from field(x, y, z, i, k), where i and
+// k index the corner column. Returns +1 if every corner is solid, -1 if every
+// corner is air, 0 if mixed; interpolated values lie between the corners, so
+// a single sign means a single block.
+template <typename Field>
+static int sampleLattice(DensityLattice& lattice, int originX, int bottomY, int originZ, Field field) {
+    bool anySolid = false, anyAir = false;
+    for (int i = 0; i < LATTICE_XZ; ++i) {
+        for (int j = 0; j < LATTICE_Y; ++j) {
+            for (int k = 0; k < LATTICE_XZ; ++k) {
+                float density = field((float)(originX + i * DENSITY_CELL_XZ), (float)(bottomY + j * DENSITY_CELL_Y),
+                                      (float)(originZ + k * DENSITY_CELL_XZ), i, k);
+                lattice[i][j][k] = density;
+                anySolid = anySolid || density > 0.0f;
+                anyAir = anyAir || density <= 0.0f;
+            }
+        }
+    }
+    return anyAir ? (anySolid ? 0 : -1) : 1;
+}
+
+// Calls block(x, y, z, solid) for every block of the chunk, solid where the
+// trilinearly interpolated density is positive
+template <typename Visit>
+static void interpolateLattice(const DensityLattice& lattice, Visit block) {
+    for (int x = 0; x < CHUNK_SIZE; ++x) {
+        int i = x / DENSITY_CELL_XZ;
+        float fx = (float)(x % DENSITY_CELL_XZ) / DENSITY_CELL_XZ;
+        for (int z = 0; z < CHUNK_SIZE; ++z) {
+            int k = z / DENSITY_CELL_XZ;
+            float fz = (float)(z % DENSITY_CELL_XZ) / DENSITY_CELL_XZ;
+
+            // Bilinear in x and z once per lattice row, then linear in y per block
+            float column[LATTICE_Y];
+            for (int j = 0; j < LATTICE_Y; ++j) {
+                column[j] = lerp(lerp(lattice[i][j][k], lattice[i + 1][j][k], fx),
+                                 lerp(lattice[i][j][k + 1], lattice[i + 1][j][k + 1], fx), fz);
+            }
+            for (int y = 0; y < CHUNK_SIZE; ++y) {
+                int j = y / DENSITY_CELL_Y;
+                float fy = (float)(y % DENSITY_CELL_Y) / DENSITY_CELL_Y;
+                block(x, y, z, lerp(column[j], column[j + 1], fy) > 0.0f);
+            }
+        }
+    }
+}
+
+// Largest multiple of step at or below value
+static int floorToMultiple(int value, int step) {
+    return (value >= 0 ? value / step : -((-value + step - 1) / step)) * step;
+}
+
+// Topmost solid block of column (x, z) in the ground generateDensity builds,
+// from the same lattice corners and the same interpolation. A column's
+// density only falls off above the surface by up to SHAPE_STRENGTH *
+// DENSITY_FALLOFF, so the scan starts just above that and steps down a
+// lattice level at a time.
+static int densitySurface(int x, int z) {
+    int x0 = floorToMultiple(x, DENSITY_CELL_XZ), z0 = floorToMultiple(z, DENSITY_CELL_XZ);
+    float fx = (float)(x - x0) / DENSITY_CELL_XZ;
+    float fz = (float)(z - z0) / DENSITY_CELL_XZ;
+    float surfaces[4];
+    columnNoise(x0, z0, DENSITY_CELL_XZ, 2, 2, surfaces);
+    float highest = -1e9f;
+    for (float& surface : surfaces) {
+        surface = surfaceFromNoise(surface);
+        highest = std::max(highest, surface);
+    }
+    // Corners with no weight are skipped; lerp(a, a, t) is exactly a, so on a
+    // lattice column (the horizon grid) only one corner costs any 3D noise
+    auto corner = [&](int c, float y) {
+        return shapeDensity((float)(x0 + (c >> 1) * DENSITY_CELL_XZ), y, (float)(z0 + (c & 1) * DENSITY_CELL_XZ),
+                            surfaces[c]);
+    };
+    auto density = [&](int y) {
+        float c00 = corner(0, (float)y);
+        float c01 = fz > 0.0f ? corner(1, (float)y) : c00;
+        float c10 = fx > 0.0f ? corner(2, (float)y) : c00;
+        float c11 = fx > 0.0f && fz > 0.0f ? corner(3, (float)y) : (fx > 0.0f ? c10 : c01);
+        return lerp(lerp(c00, c10, fx), lerp(c01, c11, fx), fz);
+    };
+
+    int y = floorToMultiple((int)std::ceil(highest + SHAPE_STRENGTH * DENSITY_FALLOFF) + DENSITY_CELL_Y - 1,
+                            DENSITY_CELL_Y);
+    float above = density(y);
+    for (;;) {
+        y -= DENSITY_CELL_Y;
+        float below = density(y);
+        if (below > 0.0f) {
+            for (int step = DENSITY_CELL_Y - 1; step > 0; --step)
+                if (lerp(below, above, (float)step / DENSITY_CELL_Y) > 0.0f)
+                    return y + step;
+            return y;
+        }
+        above = below;
+    }
+}
+
+void getSurfaceHeights(int originX, int originZ, int step, int sizeX, int sizeZ, int* out) {
+    if (terrainGenerator() != TERRAIN_DENSITY) {
+        getHeights(originX, originZ, step, sizeX, sizeZ, out);
+        return;
+    }
+    for (int i = 0; i < sizeX; ++i)
+        for (int j = 0; j < sizeZ; ++j)
+            out[i * sizeZ + j] = densitySurface(originX + i * step, originZ + j * step);
+}
+
+static int sampleCaves(DensityLattice& lattice, int chunkX, int chunkY, int chunkZ) {
+    return sampleLattice(lattice, chunkX * CHUNK_SIZE, chunkY * CHUNK_SIZE, chunkZ * CHUNK_SIZE,
+                         [](float x, float y, float z, int, int) { return caveDensity(x, y, z); });
+}
+
+// The ground, and with withCaves the caves too, in a single pack
+static void generateDensity(BlockStorage& blocks, int chunkX, int chunkY, int chunkZ, bool withCaves) {
+    int originX = chunkX * CHUNK_SIZE;
+    int bottomY = chunkY * CHUNK_SIZE;
+    int originZ = chunkZ * CHUNK_SIZE;
+
+    float surfaces[LATTICE_XZ * LATTICE_XZ];
+    columnNoise(originX, originZ, DENSITY_CELL_XZ, LATTICE_XZ, LATTICE_XZ, surfaces);
+    float highest = surfaceFromNoise(surfaces[0]);
+    for (float& surface : surfaces) {
+        surface = surfaceFromNoise(surface);
+        highest = std::max(highest, surface);
+    }
+
+    // Density stays below (surface - y) / DENSITY_FALLOFF + SHAPE_STRENGTH, so
+    // sections this far above every surface are air without any 3D noise
+    if (bottomY > highest + SHAPE_STRENGTH * DENSITY_FALLOFF) {
+        blocks.reset(BLOCK_AIR);
+        return;
+    }
+
+    DensityLattice ground;
+    int groundSign = sampleLattice(ground, originX, bottomY, originZ, [&](float x, float y, float z, int i, int k) {
+        return shapeDensity(x, y, z, surfaces[i * LATTICE_XZ + k]);
+    });
+    DensityLattice caves;
+    int caveSign = groundSign >= 0 && withCaves ? sampleCaves(caves, chunkX, chunkY, chunkZ) : 1;
+    if (groundSign < 0 || caveSign < 0) {
+        blocks.reset(BLOCK_AIR);
+        return;
+    }
+    if (groundSign > 0 && caveSign > 0) {
+        blocks.reset(BLOCK_STONE);
+        return;
+    }
+
+    int dense[CHUNK_VOLUME];
+    if (groundSign == 0) {
+        interpolateLattice(ground, [&](int x, int y, int z, bool solid) {
+            dense[BlockStorage::index(x, y, z)] = solid ? BLOCK_STONE : BLOCK_AIR;
+        });
+    }
+    else {
+        std::fill(dense, dense + CHUNK_VOLUME, BLOCK_STONE);
+    }
+    if (caveSign == 0) {
+        interpolateLattice(caves, [&](int x, int y, int z, bool solid) {
+            if (!solid)
+                dense[BlockStorage::index(x, y, z)] = BLOCK_AIR;
+        });
+    }
+    blocks.pack(dense);
+}
+
+void generateShape(BlockStorage& blocks, int chunkX, int chunkY, int chunkZ) {
+    if (terrainGenerator() == TERRAIN_DENSITY)
+        generateDensity(blocks, chunkX, chunkY, chunkZ, false);
+    else
+        generateHeightmap(blocks, chunkX, chunkY, chunkZ);
+}
+
+void carveCaves(BlockStorage& blocks, int chunkX, int chunkY, int chunkZ) {
+    if (terrainGenerator() != TERRAIN_DENSITY)
+        return;
+    if (blocks.isUniform() && blocks.uniformBlock() == BLOCK_AIR)
+        return;
+
+    DensityLattice caves;
+    int sign = sampleCaves(caves, chunkX, chunkY, chunkZ);
+    if (sign > 0)
+        return;  // no cave reaches into this section
+    if (sign < 0) {
+        blocks.reset(BLOCK_AIR);
+        return;
+    }
+
+    int dense[CHUNK_VOLUME];
+    blocks.unpack(dense);
+    interpolateLattice(caves, [&](int x, int y, int z, bool solid) {
+        if (!solid)
+            dense[BlockStorage::index(x, y, z)] = BLOCK_AIR;
+    });
+    blocks.pack(dense);
+}
+
+void generateBlocks(BlockStorage& blocks, int chunkX, int chunkY, int chunkZ) {
+    if (terrainGenerator() == TERRAIN_DENSITY)
+        generateDensity(blocks, chunkX, chunkY, chunkZ, true);
+    else
+        generateHeightmap(blocks, chunkX, chunkY, chunkZ);
+}
+
+void generateChunk(Chunk& chunk, int chunkX, int chunkY, int chunkZ) {
+    chunk.resetBlocks(0);  // unshares without a copy, otherwise keeps the buffers
+    generateBlocks(chunk.editBlocks(), chunkX, chunkY, chunkZ);
+    chunk.dirty = true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "chunk.h"
+
+// Block ids written by world generation; any id but air is solid
+const int BLOCK_AIR = 0;
+const int BLOCK_STONE = 1;
+const int BLOCK_DIRT = 2;
+const int BLOCK_GRASS = 3;
+const int BLOCK_LOG = 4;
+const int BLOCK_LEAVES = 5;
+
+// Heightmap from fractal noise, in blocks
+const int TERRAIN_BASE_HEIGHT = 8;
+const float TERRAIN_AMPLITUDE = 28.0f;
+
+// Surface height of the world column at (x, z)
+int getHeight(int x, int z);
+
+// Heights of a sizeX by sizeZ grid of columns step blocks apart, starting at
+// (originX, originZ); out[i * sizeZ + j] is column (originX + i * step,
+// originZ + j * step). One SIMD batch, and equal to getHeight column by column.
+void getHeights(int originX, int originZ, int step, int sizeX, int sizeZ, int* out);
+
+// === Density terrain ===
+// A 3D field, positive inside solid ground: the distance below the heightmap
+// surface, bent by 3D noise into overhangs, with caves cut where a second 3D
+// noise runs high. Noise at every block would cost ~4096 3D lookups per chunk,
+// so the generator samples the field on a coarse lattice and interpolates
+// trilinearly in between; features smaller than a cell are smoothed away.
+const int DENSITY_CELL_XZ = 4;  // lattice spacing in blocks; both divide CHUNK_SIZE
+const int DENSITY_CELL_Y = 8;
+
+// The field evaluated right at block (x, y, z), without the lattice
+float terrainDensity(int x, int y, int z);
+
+enum TerrainGenerator {
+    TERRAIN_HEIGHTMAP,  // solid up to the heightmap surface
+    TERRAIN_DENSITY     // solid where the interpolated density is positive
+};
+
+// Generator used by generateBlocks; set it before chunks are generated, since
+// chunks generated before and after the switch will not line up
+void setTerrainGenerator(TerrainGenerator generator);
+TerrainGenerator terrainGenerator();
+
+// Height of the topmost solid block the current generator puts in each column
+// of a grid laid out like getHeights, before caves and decoration. For the
+// heightmap generator that is getHeights; for the density one it follows the
+// overhangs exactly as the chunks are generated.
+void getSurfaceHeights(int originX, int originZ, int step, int sizeX, int sizeZ, int* out);
+
+// Fills the blocks of the chunk at chunk coordinates (chunkX, chunkY, chunkZ)
+// with the current generator; touches nothing else, so it is safe on any thread
+void generateBlocks(BlockStorage& blocks, int chunkX, int chunkY, int chunkZ);
+
+// The two passes of generateBlocks, for callers that run them as separate
+// stages: the ground without caves, then the caves cut out of it. Caves come
+// with the density generator only; for the heightmap carving does nothing.
+void generateShape(BlockStorage& blocks, int chunkX, int chunkY, int chunkZ);
+void carveCaves(BlockStorage& blocks, int chunkX, int chunkY, int chunkZ);
+
+// Fills the chunk at chunk coordinates (chunkX, chunkY, chunkZ) with the current generator
+void generateChunk(Chunk& chunk, int chunkX, int chunkY, int chunkZ);
@@ -0,0 +1,102 @@
+#include <deque>
+#include "visibility.h"
+
+ChunkConnectivity computeConnectivity(const BlockStorage& blocks) {
+    const int N = CHUNK_SIZE;
+    ChunkConnectivity result;
+
+    // Uniform chunks: open air links every face, solid links none
+    if (blocks.isUniform())
+        return blocks.uniformBlock() == 0 ? ChunkConnectivity::open() : result;
+
+    std::vector<unsigned char> visited(CHUNK_VOLUME, 0);
+    std::vector<int> stack;
+    std::vector<int> dense(CHUNK_VOLUME);
+    blocks.unpack(dense.data());
+
+    // Cells are numbered in BlockStorage::index order
+    for (int start = 0; start < CHUNK_VOLUME; ++start) {
+        if (visited[start] || dense[start] != 0)
+            continue;
+
+        // Collect the faces this air pocket reaches
+        int touched = 0;
+        visited[start] = 1;
+        stack.push_back(start);
+        while (!stack.empty()) {
+            int cell = stack.back();
+            stack.pop_back();
+            int x, y, z;
+            BlockStorage::coords(cell, x, y, z);
+
+            for (int f = 0; f < FACE_COUNT; ++f) {
+                int nx = x + faceNormals[f][0];
+                int ny = y + faceNormals[f][1];
+                int nz = z + faceNormals[f][2];
+                if (nx < 0 || ny < 0 || nz < 0 || nx >= N || ny >= N || nz >= N) {
+                    touched |= 1 << f;
+                    continue;
+                }
+                int next = BlockStorage::index(nx, ny, nz);
+                if (visited[next] || dense[next] != 0)
+                    continue;
+                visited[next] = 1;
+                stack.push_back(next);
+            }
+        }
+
+        for (int a = 0; a < FACE_COUNT; ++a)
+            for (int b = 0; b < FACE_COUNT; ++b)
+                if ((touched >> a & 1) && (touched >> b & 1))
+                    result.connect(a, b);
+    }
+    return result;
+}
+
+int findVisibleChunks(const glm::ivec3& cameraChunk, const ChunkLookup& lookup,
+                      const std::vector<ChunkConnectivity>& connectivity, std::vector<unsigned char>& visible) {
+    visible.assign(connectivity.size(), 0);
+
+    int start = lookup(cameraChunk.x, cameraChunk.y, cameraChunk.z);
+    if (start < 0) {
+        visible.assign(connectivity.size(), 1);
+        return (int)connectivity.size();
+    }
+
+    struct Step {
+        glm::ivec3 pos;
+        int index;
+        int entryFace;   // face we came in through, -1 for the camera chunk
+        int directions;  // bit per face direction already travelled
+    };
+
+    std::deque<Step> queue;
+    queue.push_back(Step{ cameraChunk, start, -1, 0 });
+    visible[start] = 1;
+    int visibleCount = 1;
+
+    while (!queue.empty()) {
+        Step step = queue.front();
+        queue.pop_front();
+
+        for (int f = 0; f < FACE_COUNT; ++f) {
+            if (f == step.entryFace)
+                continue;
+            // Never turn back towards the camera
+            if (step.directions & (1 << oppositeFace(f)))
+                continue;
+            if (step.entryFace >= 0 && !connectivity[step.index].connected(step.entryFace, f))
+                continue;
+
+            glm::ivec3 next = step.pos + glm::ivec3(faceNormals[f][0], faceNormals[f][1], faceNormals[f][2]);
+            int index = lookup(next.x, next.y, next.z);
+            if (index < 0 || visible[index])
+                continue;
+
+            visible[index] = 1;
+            ++visibleCount;
+            queue.push_back(Step{ next, index, oppositeFace(f), step.directions | (1 << f) });
+        }
+    }
+    return visibleCount;
+}
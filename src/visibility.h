@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunk.h"
+#include "mesher.h"
+
+// Which pairs of chunk faces can see each other through connected air.
+// Bit (a * FACE_COUNT + b) is set when faces a and b are linked.
+struct ChunkConnectivity {
+    uint64_t bits = 0;
+
+    bool connected(int a, int b) const { return (bits >> (a * FACE_COUNT + b)) & 1; }
+    void connect(int a, int b) {
+        bits |= 1ull << (a * FACE_COUNT + b);
+        bits |= 1ull << (b * FACE_COUNT + a);
+    }
+
+    // Every pair of faces linked, as for open air; also the stand-in for a
+    // chunk not flood filled yet, so it never hides what lies behind it
+    static ChunkConnectivity open() {
+        ChunkConnectivity result;
+        for (int a = 0; a < FACE_COUNT; ++a)
+            for (int b = 0; b < FACE_COUNT; ++b)
+                result.connect(a, b);
+        return result;
+    }
+};
+
+inline int oppositeFace(int face) { return face ^ 1; }
+
+// Flood fills the chunk's air and links every pair of faces each air pocket touches
+ChunkConnectivity computeConnectivity(const BlockStorage& blocks);
+
+// Index of the loaded chunk at chunk coordinates, or -1
+typedef std::function<int(int chunkX, int chunkY, int chunkZ)> ChunkLookup;
+
+// Breadth-first search from the camera chunk that only steps from a chunk's
+// entry face to exit faces connected to it, and never back towards the camera,
+// so chunks sealed off by solid terrain are never reached. visible[i] is set
+// for every reached chunk; returns the count. When the camera chunk is not
+// loaded (e.g. up in the sky) every chunk is marked visible.
+int findVisibleChunks(const glm::ivec3& cameraChunk, const ChunkLookup& lookup,
+                      const std::vector<ChunkConnectivity>& connectivity, std::vector<unsigned char>& visible);
@@ -0,0 +1,163 @@
+#include <cmath>
+#include "world.h"
+
+// splitmix64 finalizer: spreads neighbouring coordinates across the table
+static uint64_t hashKey(uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    key ^= key >> 31;
+    return key;
+}
+
+World::World() : pool(1024) {
+    rehash(64);
+}
+
+// Slot holding key, or the empty slot where it would be inserted
+size_t World::slotFor(uint64_t key) const {
+    size_t mask = slotKeys.size() - 1;
+    size_t slot = hashKey(key) & mask;
+    while (slotKeys[slot] != EMPTY_KEY && slotKeys[slot] != key)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+void World::rehash(size_t newCapacity) {
+    slotKeys.assign(newCapacity, EMPTY_KEY);
+    slotIndices.assign(newCapacity, -1);
+    for (int i = 0; i < (int)coords.size(); ++i) {
+        if (!loaded[i])
+            continue;
+        uint64_t key = packChunkKey(coords[i].x, coords[i].y, coords[i].z);
+        size_t slot = slotFor(key);
+        slotKeys[slot] = key;
+        slotIndices[slot] = i;
+    }
+}
+
+int World::findChunk(int chunkX, int chunkY, int chunkZ) const {
+    uint64_t key = packChunkKey(chunkX, chunkY, chunkZ);
+    if (key == cachedKey)
+        return cachedIndex;
+    int index = slotIndices[slotFor(key)];
+    cachedKey = key;
+    cachedIndex = index;
+    return index;
+}
+
+Chunk* World::getChunk(int chunkX, int chunkY, int chunkZ) {
+    int index = findChunk(chunkX, chunkY, chunkZ);
+    return index >= 0 ? &pool.at(index) : nullptr;
+}
+
+const Chunk* World::getChunk(int chunkX, int chunkY, int chunkZ) const {
+    int index = findChunk(chunkX, chunkY, chunkZ);
+    return index >= 0 ? &pool.at(index) : nullptr;
+}
+
+int World::addChunk(int chunkX, int chunkY, int chunkZ) {
+    int existing = findChunk(chunkX, chunkY, chunkZ);
+    if (existing >= 0)
+        return existing;
+
+    if ((size_t)(loadedChunks + 1) * 2 > slotKeys.size())
+        rehash(slotKeys.size() * 2);
+
+    int index = pool.allocate();
+    if (index < (int)coords.size()) {
+        coords[index] = glm::ivec3(chunkX, chunkY, chunkZ);
+        loaded[index] = 1;
+        idleTime[index] = 0.0f;
+    }
+    else {
+        coords.emplace_back(chunkX, chunkY, chunkZ);
+        loaded.push_back(1);
+        idleTime.push_back(0.0f);
+    }
+    ++loadedChunks;
+
+    uint64_t key = packChunkKey(chunkX, chunkY, chunkZ);
+    size_t slot = slotFor(key);
+    slotKeys[slot] = key;
+    slotIndices[slot] = index;
+    cachedKey = EMPTY_KEY;
+    return index;
+}
+
+void World::removeChunk(int index) {
+    if (!loaded[index])
+        return;
+
+    // Backward-shift deletion: pull later entries of the probe run into the hole
+    // so lookups never need tombstones
+    size_t mask = slotKeys.size() - 1;
+    size_t hole = slotFor(packChunkKey(coords[index].x, coords[index].y, coords[index].z));
+    size_t slot = (hole + 1) & mask;
+    while (slotKeys[slot] != EMPTY_KEY) {
+        size_t ideal = hashKey(slotKeys[slot]) & mask;
+        bool canMove = hole < slot ? (ideal <= hole || ideal > slot) : (ideal <= hole && ideal > slot);
+        if (canMove) {
+            slotKeys[hole] = slotKeys[slot];
+            slotIndices[hole] = slotIndices[slot];
+            hole = slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    slotKeys[hole] = EMPTY_KEY;
+    slotIndices[hole] = -1;
+
+    pool.release(index);
+    loaded[index] = 0;
+    --loadedChunks;
+    cachedKey = EMPTY_KEY;
+}
+
+void World::compressColdChunks(float elapsedSeconds, float idleSeconds) {
+    for (int i = 0; i < pool.capacity(); ++i) {
+        Chunk& chunk = pool.at(i);
+        if (!loaded[i] || chunk.blocks().isUniform())
+            continue;
+        if (chunk.takeReferenced()) {
+            idleTime[i] = 0.0f;
+            continue;
+        }
+        idleTime[i] += elapsedSeconds;
+        if (idleTime[i] >= idleSeconds && !chunk.blocks().isCompressed())
+            chunk.compressBlocks();  // no-op while a snapshot shares the blocks
+    }
+}
+
+ColdTierStats World::coldTierStats() const {
+    ColdTierStats stats;
+    for (int i = 0; i < pool.capacity(); ++i) {
+        const BlockStorage& blocks = pool.at(i).blocks();
+        if (!loaded[i] || blocks.isUniform())
+            continue;
+        if (blocks.isCompressed()) {
+            ++stats.coldChunks;
+            stats.coldBytes += blocks.memoryUsage();
+        }
+        else {
+            ++stats.hotChunks;
+            stats.hotBytes += blocks.memoryUsage();
+        }
+    }
+    ColdStorageStats storage = coldStorageStats();
+    stats.hits = storage.idleHits - hitsAtStart;
+    stats.misses = storage.decompressions - missesAtStart;
+    stats.averageDecompressMicros = storage.averageDecompressMicros();
+    return stats;
+}
+
+int World::getBlock(int x, int y, int z) const {
+    const Chunk* chunk = getChunk(floorDiv(x, CHUNK_SIZE), floorDiv(y, CHUNK_SIZE), floorDiv(z, CHUNK_SIZE));
+    if (!chunk)
+        return 0;
+    return chunk->get(floorMod(x, CHUNK_SIZE), floorMod(y, CHUNK_SIZE), floorMod(z, CHUNK_SIZE));
+}
+
+bool World::isBlockSolid(const glm::vec3& worldPos) const {
+    return getBlock((int)std::floor(worldPos.x), (int)std::floor(worldPos.y), (int)std::floor(worldPos.z)) != 0;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunk.h"
+#include "chunk_pool.h"
+
+// Rounds towards negative infinity, so block -1 lands in chunk -1 at local 15
+inline int floorDiv(int a, int b) {
+    int q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+inline int floorMod(int a, int b) {
+    return a - floorDiv(a, b) * b;
+}
+
+// 21 bits per axis, enough for +-1M chunks
+inline uint64_t packChunkKey(int chunkX, int chunkY, int chunkZ) {
+    const uint64_t mask = (1ull << 21) - 1;
+    return ((uint64_t)chunkX & mask) << 42 | ((uint64_t)chunkY & mask) << 21 | ((uint64_t)chunkZ & mask);
+}
+
+// Snapshot of the in-memory cold tier. Counted when blocks that went a whole
+// sweep interval unused are next accessed: a hit if they were not compressed
+// yet, a miss if the access had to decompress them.
+struct ColdTierStats {
+    int hotChunks = 0;   // non-uniform chunks held as plain index words
+    int coldChunks = 0;  // compressed ones
+    size_t hotBytes = 0;
+    size_t coldBytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    double averageDecompressMicros = 0.0;
+
+    double hitRate() const { return hits + misses ? (double)hits / (hits + misses) : 1.0; }
+};
+
+// Loaded chunks, addressed by index for per-chunk side tables and by chunk
+// coordinates through an open-addressing hash map, so finding a chunk or a
+// block is O(1) however many chunks are loaded. Indices and Chunk references
+// stay valid until the chunk is removed; chunks live in a ChunkPool, and freed
+// slots (with their block buffers) are handed out again by addChunk.
+class World {
+public:
+    World();
+
+    // Index of the chunk at chunk coordinates, or -1 if it is not loaded
+    int findChunk(int chunkX, int chunkY, int chunkZ) const;
+    Chunk* getChunk(int chunkX, int chunkY, int chunkZ);
+    const Chunk* getChunk(int chunkX, int chunkY, int chunkZ) const;
+
+    // Adds an all-air chunk (or finds the existing one) and returns its index
+    int addChunk(int chunkX, int chunkY, int chunkZ);
+    void removeChunk(int index);
+
+    // Indices run from 0 to chunkCapacity() - 1; skip the ones not loaded
+    int chunkCapacity() const { return pool.capacity(); }
+    bool isLoaded(int index) const { return loaded[index] != 0; }
+    int loadedCount() const { return loadedChunks; }
+    Chunk& chunk(int index) { return pool.at(index); }
+    const Chunk& chunk(int index) const { return pool.at(index); }
+    const glm::ivec3& chunkCoord(int index) const { return coords[index]; }
+
+    // World position of the chunk's first block
+    glm::vec3 chunkOrigin(int index) const { return glm::vec3(coords[index] * CHUNK_SIZE); }
+
+    // Block id at world block coordinates, air where no chunk is loaded.
+    // Remembers the last chunk hit, so runs of nearby queries skip the hash.
+    int getBlock(int x, int y, int z) const;
+    bool isBlockSolid(const glm::vec3& worldPos) const;
+
+    // Call every elapsedSeconds or so: compresses chunks whose blocks were not
+    // accessed for idleSeconds. Compressed chunks come back on their next access.
+    void compressColdChunks(float elapsedSeconds, float idleSeconds);
+    ColdTierStats coldTierStats() const;
+
+private:
+    static constexpr uint64_t EMPTY_KEY = ~0ull;  // packChunkKey never sets the top bit
+
+    size_t slotFor(uint64_t key) const;
+    void rehash(size_t newCapacity);
+
+    ChunkPool pool;
+    std::vector<glm::ivec3> coords;
+    std::vector<unsigned char> loaded;
+    std::vector<float> idleTime;  // seconds since the blocks were last accessed
+    uint64_t hitsAtStart = coldStorageStats().idleHits;
+    uint64_t missesAtStart = coldStorageStats().decompressions;
+    int loadedChunks = 0;
+
+    // Linear-probing table, capacity a power of two, at most half full
+    std::vector<uint64_t> slotKeys;
+    std::vector<int> slotIndices;
+
+    mutable uint64_t cachedKey = EMPTY_KEY;
+    mutable int cachedIndex = -1;
+};
@@ -0,0 +1,459 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include "noise.h"
+#include "terrain.h"
+#include "world.h"
+#include "worldgen.h"
+
+const int SURFACE_DIRT_DEPTH = 3;  // dirt blocks under the grass
+const int TREES_PER_COLUMN_MAX = 5;
+const int TRUNK_MIN = 4;           // trunks are 4 to 6 blocks tall
+const int TREE_REACH = 2;          // leaves spread this far from the trunk
+const uint16_t ALL_DECORATED = 0x1FF;
+
+static_assert(TREE_REACH < CHUNK_SIZE, "trees may only reach into adjacent columns");
+
+static NoiseSettings makeForestNoise() {
+    NoiseSettings settings;
+    settings.seed = 7331;
+    settings.octaves = 2;
+    settings.frequency = 1.0f / 256.0f;
+    return settings;
+}
+
+// Patches of forest and open ground
+static const NoiseSettings forestNoise = makeForestNoise();
+
+static uint64_t columnKey(const glm::ivec2& column) {
+    return packChunkKey(column.x, 0, column.y);
+}
+
+static int ringOf(const glm::ivec2& column, const glm::ivec2& centre) {
+    return std::max(std::abs(column.x - centre.x), std::abs(column.y - centre.y));
+}
+
+// Bit of the column at offset (dx, dz) in a 3x3 neighbourhood, each in -1..1
+static int neighbourSlot(int dx, int dz) {
+    return (dx + 1) * 3 + (dz + 1);
+}
+
+const char* chunkStatusName(ChunkStatus status) {
+    switch (status) {
+    case STATUS_EMPTY: return "empty";
+    case STATUS_TERRAIN: return "terrain";
+    case STATUS_CARVED: return "carve";
+    case STATUS_SURFACE: return "surface";
+    case STATUS_DECORATED: return "decorate";
+    case STATUS_FULL: return "full";
+    default: return "unknown";
+    }
+}
+
+// === Stages ===
+
+// The top solid block of every (x, z) becomes grass, with dirt under it
+static void coverSurface(std::vector<BlockStorage>& sections) {
+    int count = (int)sections.size();
+    thread_local std::vector<int> dense;
+    thread_local std::vector<char> changed;
+    dense.resize((size_t)count * CHUNK_VOLUME);
+    changed.assign(count, 0);
+    for (int s = 0; s < count; ++s)
+        sections[s].unpack(&dense[(size_t)s * CHUNK_VOLUME]);
+
+    for (int x = 0; x < CHUNK_SIZE; ++x) {
+        for (int z = 0; z < CHUNK_SIZE; ++z) {
+            int depth = -1;  // solid blocks seen so far, -1 before the first
+            for (int y = count * CHUNK_SIZE - 1; y >= 0 && depth < SURFACE_DIRT_DEPTH; --y) {
+                int s = y / CHUNK_SIZE;
+                int& block = dense[(size_t)s * CHUNK_VOLUME + BlockStorage::index(x, y % CHUNK_SIZE, z)];
+                if (block == BLOCK_AIR) {
+                    if (depth >= 0)
+                        break;
+                    continue;
+                }
+                block = depth < 0 ? BLOCK_GRASS : BLOCK_DIRT;
+                changed[s] = 1;
+                ++depth;
+            }
+        }
+    }
+    for (int s = 0; s < count; ++s)
+        if (changed[s])
+            sections[s].pack(&dense[(size_t)s * CHUNK_VOLUME]);
+}
+
+// The 3x3 columns around a decorating column, null where one is not written
+struct Neighbourhood {
+    glm::ivec2 centre;
+    int minChunkY;
+    std::array<std::vector<BlockStorage>*, 9> columns;
+
+    // Logs replace air and leaves, leaves only air, so overlapping trees end
+    // up the same whichever is placed first
+    void place(int x, int y, int z, int block) const {
+        int dx = floorDiv(x, CHUNK_SIZE) - centre.x;
+        int dz = floorDiv(z, CHUNK_SIZE) - centre.y;
+        std::vector<BlockStorage>* sections = columns[neighbourSlot(dx, dz)];
+        int s = floorDiv(y, CHUNK_SIZE) - minChunkY;
+        if (!sections || s < 0 || s >= (int)sections->size())
+            return;
+        BlockStorage& storage = (*sections)[s];
+        int lx = floorMod(x, CHUNK_SIZE), ly = floorMod(y, CHUNK_SIZE), lz = floorMod(z, CHUNK_SIZE);
+        int current = storage.get(lx, ly, lz);
+        if (current == BLOCK_AIR || (block == BLOCK_LOG && current == BLOCK_LEAVES))
+            storage.set(lx, ly, lz, block);
+    }
+};
+
+static uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static int blockAt(const std::vector<BlockStorage>& sections, int x, int y, int z) {
+    return sections[y / CHUNK_SIZE].get(x, y % CHUNK_SIZE, z);
+}
+
+// Trees of the column at the centre of hood. Where they stand depends only on
+// the column's own ground, which decoration never changes.
+static void plantTrees(const std::vector<BlockStorage>& source, const Neighbourhood& hood) {
+    glm::ivec2 coord = hood.centre;
+    int originX = coord.x * CHUNK_SIZE, originZ = coord.y * CHUNK_SIZE;
+    float forest = fractalNoise(forestNoise, (float)originX + CHUNK_SIZE / 2, (float)originZ + CHUNK_SIZE / 2);
+    int trees = std::min(TREES_PER_COLUMN_MAX, std::max(0, (int)std::floor((forest + 0.15f) * 10.0f)));
+
+    uint32_t state = ((uint32_t)coord.x * 0x27d4eb2du) ^ ((uint32_t)coord.y * 0x165667b1u) ^ 0x5bd1e995u;
+    state = (state ^ (state >> 15)) * 0x2c1b3c6du;
+    state |= 1;  // xorshift never leaves zero
+    int top = (int)source.size() * CHUNK_SIZE;
+    int bottomY = hood.minChunkY * CHUNK_SIZE;
+
+    for (int t = 0; t < trees; ++t) {
+        int x = (int)(nextRandom(state) % CHUNK_SIZE);
+        int z = (int)(nextRandom(state) % CHUNK_SIZE);
+        int trunk = TRUNK_MIN + (int)(nextRandom(state) % 3);
+        uint32_t corners = nextRandom(state);
+
+        int ground = top - 1;
+        while (ground >= 0 && blockAt(source, x, ground, z) != BLOCK_GRASS)
+            --ground;
+        if (ground < 0 || ground + trunk + 2 >= top)
+            continue;
+        bool clear = true;  // other trees' logs and leaves do not count
+        for (int y = ground + 1; y <= ground + trunk && clear; ++y) {
+            int block = blockAt(source, x, y, z);
+            clear = block == BLOCK_AIR || block == BLOCK_LOG || block == BLOCK_LEAVES;
+        }
+        if (!clear)
+            continue;
+
+        int worldX = originX + x, worldZ = originZ + z;
+        int crown = bottomY + ground + trunk;
+        for (int y = crown - 2; y <= crown + 1; ++y) {
+            int radius = y < crown ? TREE_REACH : 1;
+            for (int dx = -radius; dx <= radius; ++dx) {
+                for (int dz = -radius; dz <= radius; ++dz) {
+                    // Wide layers lose a random set of corners, the topmost all four
+                    bool corner = std::abs(dx) == radius && std::abs(dz) == radius;
+                    int bit = (y - crown + 2) * 4 + (dx > 0) * 2 + (dz > 0);
+                    if (corner && (y == crown + 1 || (radius == TREE_REACH && ((corners >> bit) & 1))))
+                        continue;
+                    hood.place(worldX + dx, y, worldZ + dz, BLOCK_LEAVES);
+                }
+            }
+        }
+        for (int y = 1; y <= trunk; ++y)
+            hood.place(worldX, bottomY + ground + y, worldZ, BLOCK_LOG);
+    }
+}
+
+// === Scheduling ===
+
+WorldGenPipeline::WorldGenPipeline(int minChunkY, int maxChunkY, JobSystem* jobs)
+    : minChunkY(minChunkY), maxChunkY(maxChunkY), jobs(jobs) {
+}
+
+WorldGenPipeline::~WorldGenPipeline() {
+    for (const JobSystem::Handle& job : running)
+        jobs->wait(job);
+}
+
+WorldGenPipeline::Column& WorldGenPipeline::column(const glm::ivec2& coord) {
+    std::unique_ptr<Column>& entry = columns[columnKey(coord)];
+    if (!entry) {
+        entry.reset(new Column());
+        entry->coord = coord;
+        resetColumn(*entry);
+    }
+    return *entry;
+}
+
+// Back to nothing generated. Neighbours keep their bits for this column's
+// trees: regenerating it puts back exactly what they already hold.
+void WorldGenPipeline::resetColumn(Column& column) {
+    column.status = STATUS_EMPTY;
+    column.decoratedBy = 0;
+    column.handedOut = false;
+    column.sections.clear();
+    column.sections.resize(maxChunkY - minChunkY + 1);
+}
+
+void WorldGenPipeline::request(const glm::ivec2& coord) {
+    Column& entry = column(coord);
+    if (entry.handedOut)
+        resetColumn(entry);
+    requests[columnKey(coord)] = coord;
+}
+
+void WorldGenPipeline::retain(const glm::ivec2& centre, int radius) {
+    for (auto it = requests.begin(); it != requests.end();) {
+        if (ringOf(it->second, centre) > radius)
+            it = requests.erase(it);
+        else
+            ++it;
+    }
+    // A request decorates with its neighbours' neighbours, two columns out
+    for (auto it = columns.begin(); it != columns.end();) {
+        if (!it->second->busy && ringOf(it->second->coord, centre) > radius + 2)
+            it = columns.erase(it);
+        else
+            ++it;
+    }
+}
+
+void WorldGenPipeline::update() {
+    for (;;) {
+        collect();
+        bool started = false;
+        for (const auto& entry : requests)
+            started = advance(column(entry.second)) || started;
+        if (jobs || !started)
+            break;
+    }
+}
+
+void WorldGenPipeline::collect() {
+    running.erase(std::remove_if(running.begin(), running.end(),
+                                 [](const JobSystem::Handle& job) { return job.done(); }),
+                  running.end());
+
+    finishedStages.clear();
+    done.drain(finishedStages);
+    for (const StageDone& stage : finishedStages)
+        finish(stage);
+}
+
+// Results come back through the completion queue from workers, directly when
+// the stages run inline
+void WorldGenPipeline::deliver(const StageDone& stage) {
+    if (jobs)
+        done.push(stage);
+    else
+        finish(stage);
+}
+
+void WorldGenPipeline::finish(const StageDone& stage) {
+    Column& source = *stage.column;
+    if (stage.reached != STATUS_DECORATED) {
+        source.status = stage.reached;
+        source.busy = source.busy && !stage.unlock;
+        return;
+    }
+    source.busy = false;
+    for (int i = 0; i < stage.targetCount; ++i) {
+        Column* target = stage.targets[i];
+        glm::ivec2 offset = source.coord - target->coord;
+        target->decoratedBy |= (uint16_t)(1 << neighbourSlot(offset.x, offset.y));
+        target->busy = false;
+        bool own = (target->decoratedBy & (1 << neighbourSlot(0, 0))) != 0;
+        target->status = target->decoratedBy == ALL_DECORATED ? STATUS_FULL
+                       : own ? STATUS_DECORATED : STATUS_SURFACE;
+    }
+}
+
+void WorldGenPipeline::trim() {
+    nearRequests.clear();
+    for (const auto& request : requests)
+        for (int dx = -2; dx <= 2; ++dx)
+            for (int dz = -2; dz <= 2; ++dz)
+                nearRequests.insert(columnKey(request.second + glm::ivec2(dx, dz)));
+
+    // Every column of the 3x3 around a handed-out one is full, so none of
+    // them decorates or is decorated by it again
+    auto allAroundHandedOut = [this](const glm::ivec2& coord) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            for (int dz = -1; dz <= 1; ++dz) {
+                auto neighbour = columns.find(columnKey(coord + glm::ivec2(dx, dz)));
+                if (neighbour == columns.end() || !neighbour->second->handedOut)
+                    return false;
+            }
+        }
+        return true;
+    };
+    for (auto it = columns.begin(); it != columns.end();) {
+        const Column& entry = *it->second;
+        bool unused = !entry.busy && (nearRequests.count(it->first) == 0 ||
+                                      (entry.handedOut && allAroundHandedOut(entry.coord)));
+        if (unused)
+            it = columns.erase(it);
+        else
+            ++it;
+    }
+}
+
+void WorldGenPipeline::takeFinished(std::vector<FinishedColumn>& out) {
+    for (auto it = requests.begin(); it != requests.end();) {
+        Column& entry = column(it->second);
+        if (entry.status != STATUS_FULL || entry.busy) {
+            ++it;
+            continue;
+        }
+        FinishedColumn result;
+        result.column = entry.coord;
+        result.sections.swap(entry.sections);
+        out.push_back(std::move(result));
+        entry.handedOut = true;  // the status stays, so neighbours still count it as decorated
+        it = requests.erase(it);
+    }
+}
+
+bool WorldGenPipeline::waitForProgress() {
+    collect();
+    if (running.empty())
+        return false;
+    jobs->wait(running.front());
+    return true;
+}
+
+ChunkStatus WorldGenPipeline::status(const glm::ivec2& coord) const {
+    auto it = columns.find(columnKey(coord));
+    return it == columns.end() ? STATUS_EMPTY : it->second->status;
+}
+
+StageStats WorldGenPipeline::stageStats(ChunkStatus stage) const {
+    StageStats result;
+    result.runs = stageRuns[stage].load(std::memory_order_relaxed);
+    result.seconds = stageNanos[stage].load(std::memory_order_relaxed) * 1e-9;
+    return result;
+}
+
+void WorldGenPipeline::record(ChunkStatus stage, double seconds) {
+    stageRuns[stage].fetch_add(1, std::memory_order_relaxed);
+    stageNanos[stage].fetch_add((uint64_t)(seconds * 1e9), std::memory_order_relaxed);
+}
+
+// True if a stage was started for target
+bool WorldGenPipeline::advance(Column& target) {
+    if (target.status < STATUS_SURFACE)
+        return ensureSurface(target);
+    bool started = false;
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dz = -1; dz <= 1; ++dz) {
+            if (target.decoratedBy & (1 << neighbourSlot(dx, dz)))
+                continue;
+            started = tryDecorate(column(target.coord + glm::ivec2(dx, dz))) || started;
+        }
+    }
+    return started;
+}
+
+void WorldGenPipeline::runStage(Column& column, ChunkStatus stage) {
+    for (int i = 0; i < (int)column.sections.size(); ++i) {
+        if (stage == STATUS_TERRAIN)
+            generateShape(column.sections[i], column.coord.x, minChunkY + i, column.coord.y);
+        else if (stage == STATUS_CARVED)
+            carveCaves(column.sections[i], column.coord.x, minChunkY + i, column.coord.y);
+    }
+    if (stage == STATUS_SURFACE)
+        coverSurface(column.sections);
+}
+
+// Runs the column-local stages still missing as one chain of jobs
+bool WorldGenPipeline::ensureSurface(Column& entry) {
+    if (entry.status >= STATUS_SURFACE || entry.busy)
+        return false;
+    entry.busy = true;
+    Column* target = &entry;
+    JobSystem::Handle previous;
+    for (int stage = entry.status + 1; stage <= STATUS_SURFACE; ++stage) {
+        auto step = [this, target, stage]() {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            runStage(*target, (ChunkStatus)stage);
+            record((ChunkStatus)stage, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            deliver(StageDone{ (ChunkStatus)stage, target, stage == STATUS_SURFACE, 0, {} });
+        };
+        if (!jobs) {
+            step();
+            continue;
+        }
+        std::vector<JobSystem::Handle> after;
+        if (previous)
+            after.push_back(previous);
+        previous = jobs->submit(step, after);
+    }
+    if (previous)
+        running.push_back(previous);
+    return true;
+}
+
+// Places the trees of source in every column around it that lacks them. All
+// nine must be at the surface stage and free; a source whose sections were
+// handed out is generated again first.
+bool WorldGenPipeline::tryDecorate(Column& source) {
+    if (source.handedOut)
+        resetColumn(source);
+    bool started = false;
+    bool ready = true;
+    std::array<Column*, 9> around;
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dz = -1; dz <= 1; ++dz) {
+            Column& neighbour = column(source.coord + glm::ivec2(dx, dz));
+            around[neighbourSlot(dx, dz)] = &neighbour;
+            if (neighbour.status < STATUS_SURFACE) {
+                ready = false;
+                started = ensureSurface(neighbour) || started;
+            }
+        }
+    }
+    if (!ready)
+        return started;
+    for (Column* neighbour : around)
+        if (neighbour->busy)
+            return started;
+
+    Neighbourhood hood;
+    hood.centre = source.coord;
+    hood.minChunkY = minChunkY;
+    StageDone result{ STATUS_DECORATED, &source, true, 0, {} };
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dz = -1; dz <= 1; ++dz) {
+            Column* neighbour = around[neighbourSlot(dx, dz)];
+            bool lacking = !neighbour->handedOut && !(neighbour->decoratedBy & (1 << neighbourSlot(-dx, -dz)));
+            hood.columns[neighbourSlot(dx, dz)] = lacking ? &neighbour->sections : nullptr;
+            if (lacking)
+                result.targets[result.targetCount++] = neighbour;
+        }
+    }
+    if (result.targetCount == 0)
+        return started;
+
+    source.busy = true;
+    for (int i = 0; i < result.targetCount; ++i)
+        result.targets[i]->busy = true;
+    auto decorate = [this, hood, result]() {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        plantTrees(result.column->sections, hood);
+        record(STATUS_DECORATED, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        deliver(result);
+    };
+    if (jobs)
+        running.push_back(jobs->submit(decorate));
+    else
+        decorate();
+    return true;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunk.h"
+#include "jobs.h"
+
+// How far a column has come through world generation. Every stage works on
+// whole columns (minChunkY..maxChunkY), so the status is kept per column.
+enum ChunkStatus {
+    STATUS_EMPTY,
+    STATUS_TERRAIN,    // ground shape from the heightmap or the density field
+    STATUS_CARVED,     // caves cut out
+    STATUS_SURFACE,    // top blocks turned into grass over dirt
+    STATUS_DECORATED,  // its own trees placed, reaching up to two blocks into its neighbours
+    STATUS_FULL,       // the trees of all eight neighbours are in too; nothing writes here any more
+    STATUS_COUNT
+};
+
+const char* chunkStatusName(ChunkStatus status);
+
+// A column that reached STATUS_FULL, bottom section first
+struct FinishedColumn {
+    glm::ivec2 column;
+    std::vector<BlockStorage> sections;
+};
+
+struct StageStats {
+    uint64_t runs = 0;      // columns the stage ran for
+    double seconds = 0.0;   // summed over every thread that ran it
+};
+
+// === World generation pipeline ===
+// Brings requested columns to STATUS_FULL one stage at a time. The terrain,
+// carving and surface stages only touch their own column and run as a chain
+// of dependent jobs. Decoration writes into the eight neighbours as well, so a
+// column is decorated only once all of them reached STATUS_SURFACE and none
+// of the nine is in use by another job; a column is full once all nine around
+// it decorated it. Unrequested neighbours are generated as far as that takes
+// and cached. Trees only replace air (logs also replace leaves), so the result
+// does not depend on which neighbour decorates first, and a column evicted
+// from the cache regenerates exactly.
+// All calls come from one thread; the stages run on the JobSystem's workers,
+// or inside update() without one.
+class WorldGenPipeline {
+public:
+    WorldGenPipeline(int minChunkY, int maxChunkY, JobSystem* jobs = nullptr);
+    ~WorldGenPipeline();  // waits for running stages
+    WorldGenPipeline(const WorldGenPipeline&) = delete;
+    WorldGenPipeline& operator=(const WorldGenPipeline&) = delete;
+
+    // The column comes out of takeFinished() once it is full
+    void request(const glm::ivec2& column);
+    // Drops requests further than radius (Chebyshev) from centre, and cached
+    // columns too far away to be a neighbour's neighbour of a kept request
+    void retain(const glm::ivec2& centre, int radius);
+    // Drops cached columns no pending request can still use: those handed out
+    // along with their whole 3x3, and any further than two columns from every
+    // request. A request near a dropped column later just regenerates it.
+    void trim();
+
+    // Takes in finished stages and starts every stage that became ready.
+    // Without a JobSystem it runs stages until every request is full.
+    void update();
+    // Moves out the requested columns that are full; call after update()
+    void takeFinished(std::vector<FinishedColumn>& out);
+    // Blocks until some running stage is done; false if none is running
+    bool waitForProgress();
+
+    int requestedCount() const { return (int)requests.size(); }
+    int cachedCount() const { return (int)columns.size(); }
+    ChunkStatus status(const glm::ivec2& column) const;  // STATUS_EMPTY if not cached
+    StageStats stageStats(ChunkStatus stage) const;      // the stage that reaches this status
+
+private:
+    struct Column {
+        glm::ivec2 coord;
+        ChunkStatus status = STATUS_EMPTY;
+        uint16_t decoratedBy = 0;  // one bit per column of the 3x3 around it whose trees are in
+        bool busy = false;         // a job reads or writes it
+        bool handedOut = false;    // full, sections moved out by takeFinished()
+        std::vector<BlockStorage> sections;
+    };
+    struct StageDone {
+        ChunkStatus reached;
+        Column* column;
+        bool unlock;                    // last job of a chain
+        int targetCount;                // columns a decoration wrote into
+        std::array<Column*, 9> targets;
+    };
+
+    Column& column(const glm::ivec2& coord);
+    void resetColumn(Column& column);
+    void collect();
+    void deliver(const StageDone& stage);
+    void finish(const StageDone& stage);
+    bool advance(Column& target);
+    bool ensureSurface(Column& column);
+    bool tryDecorate(Column& source);
+    void runStage(Column& column, ChunkStatus stage);
+    void record(ChunkStatus stage, double seconds);
+
+    int minChunkY;
+    int maxChunkY;
+    JobSystem* jobs;
+
+    std::unordered_map<uint64_t, std::unique_ptr<Column>> columns;  // by column key; never moves a Column
+    std::unordered_map<uint64_t, glm::ivec2> requests;
+    std::vector<JobSystem::Handle> running;
+    CompletionQueue<StageDone> done;
+    std::vector<StageDone> finishedStages;  // scratch for collect()
+    std::unordered_set<uint64_t> nearRequests;  // scratch for trim()
+
+    std::atomic<uint64_t> stageRuns[STATUS_COUNT] = {};
+    std::atomic<uint64_t> stageNanos[STATUS_COUNT] = {};
+};
@@ -0,0 +1,286 @@
+// Headless mesher tests: exact face counts for culled meshing, including the
+// faces on the 0/15 borders against solid, air and missing neighbours, the
+// bitmask mesher cross-checked against the culled one, and LOD meshing
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "chunk.h"
+#include "mesher.h"
+#include "terrain.h"
+
+static int failures = 0;
+
+#define CHECK_EQ(actual, expected)                                                                     \
+    do {                                                                                               \
+        long long a_ = (actual), e_ = (expected);                                                      \
+        if (a_ != e_) {                                                                                \
+            std::printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_);    \
+            ++failures;                                                                                \
+        }                                                                                              \
+    } while (0)
+
+const int STONE = 1;
+const int FACE_AREA = CHUNK_SIZE * CHUNK_SIZE;
+
+// Quads in the culled mesh of blocks; a null neighbour is a missing chunk
+static int culledFaces(const BlockStorage& blocks, const BlockStorage* const neighbours[FACE_COUNT]) {
+    PaddedChunk padded;
+    ChunkMesh mesh;
+    padChunk(blocks, neighbours, padded);
+    buildChunkMesh(padded, mesh, MESH_CULLED);
+    return mesh.triangleCount() / 2;
+}
+
+// The same neighbour on all six sides
+static int culledFacesAllSides(const BlockStorage& blocks, const BlockStorage* neighbour) {
+    const BlockStorage* neighbours[FACE_COUNT];
+    for (int f = 0; f < FACE_COUNT; ++f)
+        neighbours[f] = neighbour;
+    return culledFaces(blocks, neighbours);
+}
+
+static void testSingleBlocks() {
+    BlockStorage air(0);
+
+    BlockStorage single(0);
+    single.set(7, 7, 7, STONE);
+    CHECK_EQ(culledFacesAllSides(single, nullptr), 6);
+    CHECK_EQ(culledFacesAllSides(single, &air), 6);
+
+    // The shared face of two touching blocks is hidden on both sides
+    BlockStorage pair(0);
+    pair.set(7, 7, 7, STONE);
+    pair.set(8, 7, 7, STONE);
+    CHECK_EQ(culledFacesAllSides(pair, nullptr), 10);
+
+    BlockStorage column(0);
+    for (int y = 0; y < 4; ++y)
+        column.set(3, y + 5, 3, STONE);
+    CHECK_EQ(culledFacesAllSides(column, nullptr), 4 * 4 + 2);
+}
+
+static void testFullChunk() {
+    BlockStorage full(STONE), air(0);
+    CHECK_EQ(culledFacesAllSides(full, &full), 0);
+    CHECK_EQ(culledFacesAllSides(full, &air), 6 * FACE_AREA);
+    CHECK_EQ(culledFacesAllSides(full, nullptr), 6 * FACE_AREA);
+
+    // Boxed in on every side but one
+    for (int open = 0; open < FACE_COUNT; ++open) {
+        const BlockStorage* neighbours[FACE_COUNT];
+        for (int f = 0; f < FACE_COUNT; ++f)
+            neighbours[f] = f == open ? &air : &full;
+        CHECK_EQ(culledFaces(full, neighbours), FACE_AREA);
+        neighbours[open] = nullptr;
+        CHECK_EQ(culledFaces(full, neighbours), FACE_AREA);
+    }
+
+    // meshChunk skips a boxed-in solid chunk; the result must still be empty
+    const BlockStorage* neighbours[FACE_COUNT];
+    for (int f = 0; f < FACE_COUNT; ++f)
+        neighbours[f] = &full;
+    PaddedChunk padded;
+    ChunkMesh mesh;
+    meshChunk(full, neighbours, padded, mesh, MESH_CULLED);
+    CHECK_EQ(mesh.triangleCount(), 0);
+}
+
+// A block on each 0/15 border loses exactly the face that a solid neighbour covers
+static void testBorderBlocks() {
+    BlockStorage full(STONE), air(0);
+    const int last = CHUNK_SIZE - 1;
+    for (int f = 0; f < FACE_COUNT; ++f) {
+        const int* n = faceNormals[f];
+        int x = n[0] > 0 ? last : n[0] < 0 ? 0 : 5;
+        int y = n[1] > 0 ? last : n[1] < 0 ? 0 : 6;
+        int z = n[2] > 0 ? last : n[2] < 0 ? 0 : 7;
+        BlockStorage blocks(0);
+        blocks.set(x, y, z, STONE);
+
+        const BlockStorage* neighbours[FACE_COUNT] = {};
+        CHECK_EQ(culledFaces(blocks, neighbours), 6);
+        neighbours[f] = &air;
+        CHECK_EQ(culledFaces(blocks, neighbours), 6);
+        neighbours[f] = &full;
+        CHECK_EQ(culledFaces(blocks, neighbours), 5);
+
+        // Solid neighbours on the other sides do not touch it
+        for (int g = 0; g < FACE_COUNT; ++g)
+            neighbours[g] = g == f ? &air : &full;
+        CHECK_EQ(culledFaces(blocks, neighbours), 6);
+    }
+}
+
+// Quads of a mesh as sorted vertex tuples, so meshers emitting in different orders compare equal
+static std::vector<std::vector<uint32_t>> sortedQuads(const ChunkMesh& mesh) {
+    std::vector<std::vector<uint32_t>> quads;
+    for (size_t q = 0; q + 4 <= mesh.vertices.size(); q += 4) {
+        std::vector<uint32_t> quad;
+        for (size_t i = q; i < q + 4; ++i)
+            quad.push_back(mesh.vertices[i].data);
+        quads.push_back(quad);
+    }
+    std::sort(quads.begin(), quads.end());
+    return quads;
+}
+
+// MESH_BINARY must emit exactly the quads of MESH_CULLED
+static void checkBinaryMatchesCulled(const char* name, const BlockStorage& blocks,
+                                     const BlockStorage* const neighbours[FACE_COUNT]) {
+    PaddedChunk padded;
+    ChunkMesh culled, binary;
+    padChunk(blocks, neighbours, padded);
+    buildChunkMesh(padded, culled, MESH_CULLED);
+    buildChunkMesh(padded, binary, MESH_BINARY);
+    if (sortedQuads(culled) != sortedQuads(binary)) {
+        std::printf("%s: binary mesh has %d triangles, culled mesh %d, or their quads differ\n", name,
+                    binary.triangleCount(), culled.triangleCount());
+        ++failures;
+    }
+}
+
+static void testBinaryMesher() {
+    BlockStorage empty(0), full(STONE), checkerboard(0), terrain(0);
+    for (int x = 0; x < CHUNK_SIZE; ++x)
+        for (int y = 0; y < CHUNK_SIZE; ++y)
+            for (int z = 0; z < CHUNK_SIZE; ++z)
+                if ((x + y + z) % 2 == 0)
+                    checkerboard.set(x, y, z, 1 + (x + z) % 3);  // mixed ids as well
+    Chunk generated;
+    generateChunk(generated, 3, 0, -2);
+    terrain = generated.blocks();
+    CHECK_EQ(terrain.isUniform(), false);  // a surface chunk, not all air or stone
+
+    // Every chunk against every kind of neighbour on all sides, and one at a time
+    struct Case {
+        const char* name;
+        const BlockStorage* blocks;
+    };
+    const Case chunks[] = { { "empty", &empty }, { "full", &full }, { "checkerboard", &checkerboard }, { "terrain", &terrain } };
+    const Case neighbourKinds[] = { { "missing", nullptr }, { "air", &empty }, { "solid", &full }, { "checkerboard", &checkerboard } };
+    char name[128];
+    for (const Case& chunk : chunks) {
+        for (const Case& kind : neighbourKinds) {
+            const BlockStorage* neighbours[FACE_COUNT];
+            for (int f = 0; f < FACE_COUNT; ++f)
+                neighbours[f] = kind.blocks;
+            std::snprintf(name, sizeof(name), "%s among %s neighbours", chunk.name, kind.name);
+            checkBinaryMatchesCulled(name, *chunk.blocks, neighbours);
+
+            for (int f = 0; f < FACE_COUNT; ++f) {
+                const BlockStorage* one[FACE_COUNT] = {};
+                one[f] = kind.blocks;
+                std::snprintf(name, sizeof(name), "%s with a %s neighbour on face %d", chunk.name, kind.name, f);
+                checkBinaryMatchesCulled(name, *chunk.blocks, one);
+            }
+        }
+    }
+
+    // Single blocks on each 0/15 border, against a solid and an air neighbour there
+    const int last = CHUNK_SIZE - 1;
+    for (int f = 0; f < FACE_COUNT; ++f) {
+        const int* n = faceNormals[f];
+        for (int corner = 0; corner < 2; ++corner) {
+            int inner = corner == 0 ? 0 : last;  // also on the edges of the other two axes
+            BlockStorage blocks(0);
+            blocks.set(n[0] > 0 ? last : n[0] < 0 ? 0 : inner, n[1] > 0 ? last : n[1] < 0 ? 0 : inner,
+                       n[2] > 0 ? last : n[2] < 0 ? 0 : inner, STONE);
+            for (const BlockStorage* neighbour : { &full, &empty }) {
+                const BlockStorage* neighbours[FACE_COUNT] = {};
+                neighbours[f] = neighbour;
+                std::snprintf(name, sizeof(name), "border block on face %d (%s) with %s neighbour", f,
+                              corner == 0 ? "low edge" : "high edge", neighbour == &full ? "a solid" : "an air");
+                checkBinaryMatchesCulled(name, blocks, neighbours);
+                for (int g = 0; g < FACE_COUNT; ++g)
+                    neighbours[g] = neighbour;
+                std::snprintf(name, sizeof(name), "border block on face %d (%s) among %s neighbours", f,
+                              corner == 0 ? "low edge" : "high edge", neighbour == &full ? "solid" : "air");
+                checkBinaryMatchesCulled(name, blocks, neighbours);
+            }
+        }
+    }
+}
+
+static int lodTriangles(const BlockStorage& blocks, const BlockStorage* const neighbours[FACE_COUNT], int lodScale) {
+    PaddedChunk expanded;
+    ChunkMesh mesh;
+    buildLodChunkMesh(blocks, neighbours, lodScale, expanded, mesh);
+    return mesh.triangleCount();
+}
+
+// Each lodScale^3 cell of blocks set to the block at its first corner
+static BlockStorage coarsened(const BlockStorage& blocks, int lodScale) {
+    BlockStorage result(0);
+    for (int x = 0; x < CHUNK_SIZE; ++x)
+        for (int y = 0; y < CHUNK_SIZE; ++y)
+            for (int z = 0; z < CHUNK_SIZE; ++z)
+                result.set(x, y, z, blocks.get(x - x % lodScale, y - y % lodScale, z - z % lodScale));
+    return result;
+}
+
+static void testLodMesher() {
+    BlockStorage full(STONE), air(0);
+    for (int lodScale : { 2, 4 }) {
+        const BlockStorage* neighbours[FACE_COUNT];
+        for (int f = 0; f < FACE_COUNT; ++f)
+            neighbours[f] = &full;
+        CHECK_EQ(lodTriangles(full, neighbours, lodScale), 0);  // buried
+
+        // Open on top only: one merged quad
+        neighbours[FACE_TOP] = &air;
+        CHECK_EQ(lodTriangles(full, neighbours, lodScale), 2);
+
+        // A single air block in a neighbour's touching layer uncovers one cell face
+        BlockStorage holed(STONE);
+        holed.set(0, 5, 9, 0);
+        neighbours[FACE_TOP] = &full;
+        neighbours[FACE_RIGHT] = &holed;
+        CHECK_EQ(lodTriangles(full, neighbours, lodScale), 2);
+
+        // Missing neighbours are closed walls
+        const BlockStorage* missing[FACE_COUNT] = {};
+        CHECK_EQ(lodTriangles(full, missing, lodScale), 12);
+        BlockStorage single(0);
+        single.set(7, 7, 7, STONE);
+        CHECK_EQ(lodTriangles(single, missing, lodScale), 12);
+    }
+
+    // On blocks that already come in whole cells, LOD meshing is greedy meshing
+    Chunk generated;
+    generateChunk(generated, 3, 0, -2);
+    for (int lodScale : { 2, 4 }) {
+        BlockStorage terrain = coarsened(generated.blocks(), lodScale);
+        BlockStorage full(STONE), air(0);
+        const BlockStorage* neighbourKinds[] = { nullptr, &air, &full, &terrain };
+        for (const BlockStorage* neighbour : neighbourKinds) {
+            const BlockStorage* neighbours[FACE_COUNT];
+            for (int f = 0; f < FACE_COUNT; ++f)
+                neighbours[f] = neighbour;
+            PaddedChunk padded;
+            ChunkMesh lod, greedy;
+            buildLodChunkMesh(terrain, neighbours, lodScale, padded, lod);
+            padChunk(terrain, neighbours, padded);
+            buildChunkMesh(padded, greedy, MESH_GREEDY);
+            if (sortedQuads(lod) != sortedQuads(greedy)) {
+                std::printf("LOD x%d mesh has %d triangles, greedy mesh %d, or their quads differ\n", lodScale,
+                            lod.triangleCount(), greedy.triangleCount());
+                ++failures;
+            }
+        }
+    }
+}
+
+int main() {
+    testSingleBlocks();
+    testFullChunk();
+    testBorderBlocks();
+    testBinaryMesher();
+    testLodMesher();
+    if (failures > 0) {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all mesher tests passed\n");
+    return 0;
+}
@@ -0,0 +1,193 @@
+// Headless block layout benchmark: generation, column walks, meshing,
+// connectivity, skylight and raycasts under the CHUNK_LAYOUT it was built with.
+// CMake builds one LayoutBench_<layout> per layout; the layout_bench target runs them all.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "chunk.h"
+#include "mesher.h"
+#include "terrain.h"
+#include "visibility.h"
+#include "world.h"
+
+const int AREA = 16;  // AREA x AREA chunk columns, sections -1..1
+const int ITERATIONS = 5;
+const int REPEATS = 7;  // the fastest repeat is reported, filtering out scheduling noise
+const int RAYS = 100000;
+
+typedef std::chrono::steady_clock Clock;
+
+// Shortest time of REPEATS runs of work(), in microseconds
+template <typename Work>
+static double bestOf(Work work) {
+    double best = 1e30;
+    for (int r = 0; r < REPEATS; ++r) {
+        Clock::time_point start = Clock::now();
+        work();
+        best = std::min(best, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+static void report(const char* test, double value, const char* unit) {
+    printf("%-7s %-13s %10.2f %s\n", BlockStorage::BlockLayout::name(), test, value, unit);
+}
+
+// Stand-in for a skylight pass: sunlight runs down each open column, then
+// spreads sideways through air losing one level per block
+static int propagateSkylight(const int* dense, unsigned char* light, std::vector<int>& queue) {
+    queue.clear();
+    for (int i = 0; i < CHUNK_VOLUME; ++i)
+        light[i] = 0;
+    for (int x = 0; x < CHUNK_SIZE; ++x) {
+        for (int z = 0; z < CHUNK_SIZE; ++z) {
+            for (int y = CHUNK_SIZE - 1; y >= 0; --y) {
+                int i = BlockStorage::index(x, y, z);
+                if (dense[i] != 0)
+                    break;
+                light[i] = 15;
+                queue.push_back(i);
+            }
+        }
+    }
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int cell = queue[head];
+        int x, y, z;
+        BlockStorage::coords(cell, x, y, z);
+        int level = light[cell] - 1;
+        if (level <= 0)
+            continue;
+        for (int f = 0; f < FACE_COUNT; ++f) {
+            int nx = x + faceNormals[f][0], ny = y + faceNormals[f][1], nz = z + faceNormals[f][2];
+            if (nx < 0 || ny < 0 || nz < 0 || nx >= CHUNK_SIZE || ny >= CHUNK_SIZE || nz >= CHUNK_SIZE)
+                continue;
+            int next = BlockStorage::index(nx, ny, nz);
+            if (dense[next] != 0 || light[next] >= level)
+                continue;
+            light[next] = (unsigned char)level;
+            queue.push_back(next);
+        }
+    }
+    return (int)queue.size();
+}
+
+// Steps a ray block by block (Amanatides-Woo) until it hits a solid block
+static bool castRay(const World& world, glm::vec3 origin, glm::vec3 dir, int maxSteps) {
+    glm::ivec3 cell = glm::floor(origin);
+    glm::ivec3 step(dir.x > 0 ? 1 : -1, dir.y > 0 ? 1 : -1, dir.z > 0 ? 1 : -1);
+    glm::vec3 delta = glm::abs(1.0f / dir);
+    glm::vec3 next;
+    for (int a = 0; a < 3; ++a)
+        next[a] = (dir[a] > 0 ? (cell[a] + 1 - origin[a]) : (origin[a] - cell[a])) * delta[a];
+
+    for (int s = 0; s < maxSteps; ++s) {
+        if (world.getBlock(cell.x, cell.y, cell.z) != 0)
+            return true;
+        int axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+        cell[axis] += step[axis];
+        next[axis] += delta[axis];
+    }
+    return false;
+}
+
+int main() {
+    World world;
+    std::vector<int> surface;  // indices of the sections holding the terrain surface
+    for (int x = 0; x < AREA; ++x) {
+        for (int z = 0; z < AREA; ++z) {
+            for (int y = -1; y <= 1; ++y) {
+                int index = world.addChunk(x, y, z);
+                generateChunk(world.chunk(index), x, y, z);
+                if (!world.chunk(index).blocks().isUniform())
+                    surface.push_back(index);
+            }
+        }
+    }
+
+    // Generation of surface sections, the only ones that fill a dense array
+    const double perChunk = 1.0 / (ITERATIONS * surface.size());
+    Chunk scratch(0);
+    report("generate", perChunk * bestOf([&] {
+        for (int i = 0; i < ITERATIONS; ++i)
+            for (int index : surface)
+                generateChunk(scratch, world.chunkCoord(index).x, 0, world.chunkCoord(index).z);
+    }), "us/chunk");
+
+    // Vertical collision: walk each column down to the first solid block
+    long long found = 0;
+    report("column walk", perChunk * 1000.0 / (CHUNK_SIZE * CHUNK_SIZE) * bestOf([&] {
+        for (int i = 0; i < ITERATIONS; ++i) {
+            for (int index : surface) {
+                const BlockStorage& blocks = world.chunk(index).blocks();
+                for (int x = 0; x < CHUNK_SIZE; ++x)
+                    for (int z = 0; z < CHUNK_SIZE; ++z)
+                        for (int y = CHUNK_SIZE - 1; y >= 0; --y)
+                            if (blocks.get(x, y, z) != 0) {
+                                found += y;
+                                break;
+                            }
+            }
+        }
+    }), "ns/column");
+
+    // Greedy meshing, including the gather into the padded array
+    PaddedChunk padded;
+    ChunkMesh mesh;
+    size_t triangles = 0;
+    report("mesh", perChunk * bestOf([&] {
+        for (int i = 0; i < ITERATIONS; ++i) {
+            for (int index : surface) {
+                const glm::ivec3& c = world.chunkCoord(index);
+                const BlockStorage* neighbours[FACE_COUNT];
+                for (int f = 0; f < FACE_COUNT; ++f) {
+                    const Chunk* n = world.getChunk(c.x + faceNormals[f][0], c.y + faceNormals[f][1], c.z + faceNormals[f][2]);
+                    neighbours[f] = n ? &n->blocks() : nullptr;
+                }
+                meshChunk(world.chunk(index).blocks(), neighbours, padded, mesh, MESH_GREEDY);
+                triangles += mesh.triangleCount();
+            }
+        }
+    }), "us/chunk");
+
+    uint64_t links = 0;
+    report("connectivity", perChunk * bestOf([&] {
+        for (int i = 0; i < ITERATIONS; ++i)
+            for (int index : surface)
+                links += computeConnectivity(world.chunk(index).blocks()).bits;
+    }), "us/chunk");
+
+    std::vector<int> dense(CHUNK_VOLUME), queue;
+    std::vector<unsigned char> light(CHUNK_VOLUME);
+    long long lit = 0;
+    report("skylight", perChunk * bestOf([&] {
+        for (int i = 0; i < ITERATIONS; ++i) {
+            for (int index : surface) {
+                world.chunk(index).blocks().unpack(dense.data());
+                lit += propagateSkylight(dense.data(), light.data(), queue);
+            }
+        }
+    }), "us/chunk");
+
+    // Rays from above the terrain in random downward directions, the same set every repeat
+    std::vector<glm::vec3> origins, dirs;
+    srand(1);
+    for (int r = 0; r < RAYS; ++r) {
+        origins.push_back(glm::vec3(8.0f + rand() % (AREA * CHUNK_SIZE - 16), 20.0f, 8.0f + rand() % (AREA * CHUNK_SIZE - 16)));
+        dirs.push_back(glm::normalize(glm::vec3(rand() / (float)RAND_MAX - 0.5f, -0.2f - rand() / (float)RAND_MAX,
+                                                rand() / (float)RAND_MAX - 0.5f)));
+    }
+    int hits = 0;
+    report("raycast", RAYS / bestOf([&] {
+        for (int r = 0; r < RAYS; ++r)
+            hits += castRay(world, origins[r], dirs[r], 64) ? 1 : 0;
+    }), "Mrays/s");
+
+    // Keeps the optimiser from dropping the measured work
+    printf("%-7s checksum      %lld\n", BlockStorage::BlockLayout::name(),
+        found + (long long)triangles + (long long)(links & 0xffff) + lit + hits);
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Headless mesher benchmark: vertex counts and build times per meshing mode and LOD.
+// MesherTest checks that the modes agree.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "chunk.h"
+#include "mesher.h"
+#include "terrain.h"
+
+const int AREA = 8;        // AREA x AREA chunk columns
+const int ITERATIONS = 20;
+
+struct Scene {
+    const char* name;
+    std::vector<Chunk> chunks;
+    std::vector<PaddedChunk> padded;
+};
+
+// The four horizontal neighbours of chunk c inside the scene
+static void sceneNeighbours(const Scene& scene, size_t c, const BlockStorage* neighbours[FACE_COUNT]) {
+    const std::vector<Chunk>& chunks = scene.chunks;
+    int x = (int)c / AREA, z = (int)c % AREA;
+    for (int f = 0; f < FACE_COUNT; ++f)
+        neighbours[f] = nullptr;
+    neighbours[FACE_FRONT] = z + 1 < AREA ? &chunks[x * AREA + z + 1].blocks() : nullptr;
+    neighbours[FACE_BACK] = z > 0 ? &chunks[x * AREA + z - 1].blocks() : nullptr;
+    neighbours[FACE_RIGHT] = x + 1 < AREA ? &chunks[(x + 1) * AREA + z].blocks() : nullptr;
+    neighbours[FACE_LEFT] = x > 0 ? &chunks[(x - 1) * AREA + z].blocks() : nullptr;
+}
+
+static Scene buildScene(const char* name, bool flat) {
+    Scene scene;
+    scene.name = name;
+    scene.chunks.resize(AREA * AREA);
+    std::vector<Chunk>& chunks = scene.chunks;
+    for (int x = 0; x < AREA; ++x)
+        for (int z = 0; z < AREA; ++z)
+            if (!flat)
+                generateChunk(chunks[x * AREA + z], x, 0, z);
+
+    scene.padded.resize(chunks.size());
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        const BlockStorage* neighbours[FACE_COUNT];
+        sceneNeighbours(scene, c, neighbours);
+        padChunk(chunks[c].blocks(), neighbours, scene.padded[c]);
+    }
+    return scene;
+}
+
+// build(i, mesh) meshes chunk i of the scene
+template <typename Build>
+static void benchMesher(const Scene& scene, const char* mesherName, Build build) {
+    ChunkMesh mesh;
+    size_t chunks = scene.chunks.size();
+    size_t vertices = 0, triangles = 0;
+    for (size_t c = 0; c < chunks; ++c) {
+        build(c, mesh);
+        vertices += mesh.vertices.size();
+        triangles += mesh.triangleCount();
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+        for (size_t c = 0; c < chunks; ++c)
+            build(c, mesh);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double us = std::chrono::duration<double, std::micro>(end - start).count();
+    double perChunk = us / (ITERATIONS * chunks);
+    printf("%-8s %-7s %10zu verts %8zu verts/chunk %8zu tris/chunk %9.1f KiB/chunk %9.1f us/chunk\n",
+        scene.name, mesherName, vertices, vertices / chunks, triangles / chunks,
+        vertices * sizeof(ChunkVertex) / 1024.0 / chunks, perChunk);
+}
+
+static void benchMode(const Scene& scene, MeshMode mode, const char* modeName) {
+    benchMesher(scene, modeName, [&](size_t c, ChunkMesh& mesh) {
+        buildChunkMesh(scene.padded[c], mesh, mode);
+    });
+}
+
+static void benchLod(const Scene& scene, int lodScale, const char* lodName) {
+    PaddedChunk expanded;
+    benchMesher(scene, lodName, [&](size_t c, ChunkMesh& mesh) {
+        const BlockStorage* neighbours[FACE_COUNT];
+        sceneNeighbours(scene, c, neighbours);
+        buildLodChunkMesh(scene.chunks[c].blocks(), neighbours, lodScale, expanded, mesh);
+    });
+}
+
+int main() {
+    Scene scenes[] = { buildScene("flat", true), buildScene("terrain", false) };
+    for (const Scene& scene : scenes) {
+        size_t storage = 0;
+        for (const Chunk& chunk : scene.chunks)
+            storage += chunk.blocks().memoryUsage();
+        printf("%-8s block storage %zu bytes/chunk (raw int array: %zu)\n",
+            scene.name, storage / scene.chunks.size(), sizeof(int) * CHUNK_VOLUME);
+        benchMode(scene, MESH_NAIVE, "naive");
+        benchMode(scene, MESH_CULLED, "culled");
+        benchMode(scene, MESH_GREEDY, "greedy");
+        benchMode(scene, MESH_BINARY, "binary");
+        benchLod(scene, 2, "lod2");
+        benchLod(scene, 4, "lod4");
+    }
+    return 0;
+}
@@ -0,0 +1,127 @@
+// Headless noise benchmark: fractal noise throughput per backend, a
+// bit-for-bit check of every SIMD backend against the scalar reference, and
+// density terrain from the coarse lattice against noise at every block
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "chunk.h"
+#include "noise.h"
+#include "terrain.h"
+
+const int SAMPLES = 1 << 16;
+const int REPEATS = 7;  // the fastest repeat is reported, filtering out scheduling noise
+
+typedef std::chrono::steady_clock Clock;
+
+template <typename Work>
+static double bestOf(Work work) {
+    double best = 1e30;
+    for (int r = 0; r < REPEATS; ++r) {
+        Clock::time_point start = Clock::now();
+        work();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+int main() {
+    // Scattered points over a wide area, negative coordinates included
+    std::vector<float> xs(SAMPLES), zs(SAMPLES);
+    uint32_t state = 12345;
+    for (int i = 0; i < SAMPLES; ++i) {
+        state = state * 1664525u + 1013904223u;
+        xs[i] = (float)((int)(state >> 8) % 200000 - 100000) + (state & 255) / 256.0f;
+        state = state * 1664525u + 1013904223u;
+        zs[i] = (float)((int)(state >> 8) % 200000 - 100000) + (state & 255) / 256.0f;
+    }
+
+    NoiseSettings settings;
+    std::vector<float> reference(SAMPLES);
+    for (int i = 0; i < SAMPLES; ++i)
+        reference[i] = fractalNoise(settings, xs[i], zs[i]);
+    float lowest = *std::min_element(reference.begin(), reference.end());
+    float highest = *std::max_element(reference.begin(), reference.end());
+    std::printf("%d octaves, values in [%.3f, %.3f]\n", settings.octaves, lowest, highest);
+
+    std::vector<float> out(SAMPLES);
+    bool allMatch = true;
+    for (int b = 0; b < NOISE_BACKEND_COUNT; ++b) {
+        NoiseBackend backend = (NoiseBackend)b;
+        if (!noiseBackendSupported(backend)) {
+            std::printf("%-8s not supported by this CPU\n", noiseBackendName(backend));
+            continue;
+        }
+        double seconds = bestOf([&] {
+            fractalNoiseBatch(settings, xs.data(), zs.data(), out.data(), SAMPLES, backend);
+        });
+        bool match = std::memcmp(out.data(), reference.data(), SAMPLES * sizeof(float)) == 0;
+        allMatch = allMatch && match;
+        std::printf("%-8s %8.2f Msamples/s %8.2f Moctaves/s   %s\n", noiseBackendName(backend),
+                    SAMPLES / seconds / 1e6, SAMPLES * settings.octaves / seconds / 1e6,
+                    match ? "matches scalar" : "DIFFERS FROM SCALAR");
+    }
+
+    // What generateChunk pays per chunk, and the per-column lookups it replaced
+    int heights[CHUNK_SIZE * CHUNK_SIZE];
+    const int CHUNKS = 256;
+    double batched = bestOf([&] {
+        for (int c = 0; c < CHUNKS; ++c)
+            getHeights(c * CHUNK_SIZE, -c * CHUNK_SIZE, 1, CHUNK_SIZE, CHUNK_SIZE, heights);
+    });
+    double single = bestOf([&] {
+        for (int c = 0; c < CHUNKS; ++c)
+            for (int x = 0; x < CHUNK_SIZE; ++x)
+                for (int z = 0; z < CHUNK_SIZE; ++z)
+                    heights[x * CHUNK_SIZE + z] = getHeight(c * CHUNK_SIZE + x, -c * CHUNK_SIZE + z);
+    });
+    std::printf("chunk heightmap (%s): %.2f us batched, %.2f us per column calls\n",
+                noiseBackendName(bestNoiseBackend()), batched / CHUNKS * 1e6, single / CHUNKS * 1e6);
+
+    for (int c = 0; c < CHUNKS && allMatch; ++c) {
+        getHeights(c * CHUNK_SIZE, -c * CHUNK_SIZE, 1, CHUNK_SIZE, CHUNK_SIZE, heights);
+        for (int x = 0; x < CHUNK_SIZE; ++x)
+            for (int z = 0; z < CHUNK_SIZE; ++z)
+                allMatch = allMatch && heights[x * CHUNK_SIZE + z] == getHeight(c * CHUNK_SIZE + x, -c * CHUNK_SIZE + z);
+    }
+
+    // Density chunks around the surface: lattice generation, and the 3D noise
+    // it avoids by not evaluating the field at every block
+    setTerrainGenerator(TERRAIN_DENSITY);
+    const int DENSITY_CHUNKS = 32;
+    BlockStorage blocks;
+    int dense[CHUNK_VOLUME];
+    double lattice = bestOf([&] {
+        for (int c = 0; c < DENSITY_CHUNKS; ++c)
+            generateBlocks(blocks, c, 0, -c);
+    });
+    double perBlock = bestOf([&] {
+        for (int c = 0; c < DENSITY_CHUNKS; ++c) {
+            for (int x = 0; x < CHUNK_SIZE; ++x)
+                for (int y = 0; y < CHUNK_SIZE; ++y)
+                    for (int z = 0; z < CHUNK_SIZE; ++z)
+                        dense[BlockStorage::index(x, y, z)] =
+                            terrainDensity(c * CHUNK_SIZE + x, y, -c * CHUNK_SIZE + z) > 0.0f ? 1 : 0;
+            blocks.pack(dense);
+        }
+    });
+    long long same = 0, solid = 0;
+    for (int c = 0; c < DENSITY_CHUNKS; ++c) {
+        generateBlocks(blocks, c, 0, -c);
+        for (int x = 0; x < CHUNK_SIZE; ++x)
+            for (int y = 0; y < CHUNK_SIZE; ++y)
+                for (int z = 0; z < CHUNK_SIZE; ++z) {
+                    bool latticeSolid = blocks.get(x, y, z) != 0;
+                    solid += latticeSolid;
+                    same += latticeSolid == (terrainDensity(c * CHUNK_SIZE + x, y, -c * CHUNK_SIZE + z) > 0.0f);
+                }
+    }
+    long long total = (long long)DENSITY_CHUNKS * CHUNK_VOLUME;
+    std::printf("density chunk (%dx%dx%d lattice): %.1f us, per-block noise %.1f us (%.0fx); %.1f%% solid, %.1f%% of blocks agree\n",
+                DENSITY_CELL_XZ, DENSITY_CELL_Y, DENSITY_CELL_XZ, lattice / DENSITY_CHUNKS * 1e6, perBlock / DENSITY_CHUNKS * 1e6,
+                perBlock / lattice, 100.0 * solid / total, 100.0 * same / total);
+
+    std::printf("%s\n", allMatch ? "all backends agree" : "MISMATCH");
+    return allMatch ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+// Headless world pregeneration: runs an N x N area of chunk columns around a
+// centre column through the world generation pipeline on every core, saves it
+// to a world directory in the region format and reports chunks/s and the time
+// spent in each stage. Columns already saved there are left alone, so a
+// server can pregenerate its spawn area before players join.
+//
+//   Pregen [size] [centreX centreZ] [--world DIR] [--threads N] [--heightmap]
+//
+// size is in columns (default 32); the centre is in chunk coordinates.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "autosave.h"
+#include "jobs.h"
+#include "region.h"
+#include "streaming.h"
+#include "terrain.h"
+#include "world.h"
+#include "worldgen.h"
+
+const int REQUESTS_PER_WORKER = 8;  // columns requested ahead of the ones finished
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void usage() {
+    std::fprintf(stderr, "usage: Pregen [size] [centreX centreZ] [--world DIR] [--threads N] [--heightmap]\n");
+}
+
+int main(int argc, char** argv) {
+    int size = 32;
+    int centreX = 0, centreZ = 0;
+    std::string directory = "world";
+    int workers = JobSystem::defaultWorkerCount();  // the main thread helps while it waits
+    TerrainGenerator generator = TERRAIN_DENSITY;
+
+    std::vector<int> numbers;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--world") == 0 && i + 1 < argc) {
+            directory = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            workers = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--heightmap") == 0) {
+            generator = TERRAIN_HEIGHTMAP;
+        }
+        else {
+            char* end = nullptr;
+            long value = std::strtol(argv[i], &end, 10);
+            if (!end || *end != '\0' || numbers.size() >= 3) {
+                usage();
+                return 2;
+            }
+            numbers.push_back((int)value);
+        }
+    }
+    if (numbers.size() == 2 || (!numbers.empty() && numbers[0] <= 0)) {
+        usage();
+        return 2;
+    }
+    if (!numbers.empty())
+        size = numbers[0];
+    if (numbers.size() == 3) {
+        centreX = numbers[1];
+        centreZ = numbers[2];
+    }
+    setTerrainGenerator(generator);
+
+    // Same vertical range as the game streams
+    StreamingSettings streaming;
+    int minChunkY = streaming.minChunkY, maxChunkY = streaming.maxChunkY;
+    JobSystem jobs(workers);
+    RegionStore store(directory);
+    WorldSaver saver(store, minChunkY, maxChunkY, jobs);
+    WorldGenPipeline pipeline(minChunkY, maxChunkY, &jobs);
+    World world;
+
+    // Row by row, so the neighbours one request generates serve the next ones
+    std::vector<glm::ivec2> columns;
+    int skipped = 0;
+    int firstX = centreX - size / 2, firstZ = centreZ - size / 2;
+    for (int x = firstX; x < firstX + size; ++x) {
+        for (int z = firstZ; z < firstZ + size; ++z) {
+            if (store.hasColumn(x, z))
+                ++skipped;
+            else
+                columns.push_back(glm::ivec2(x, z));
+        }
+    }
+    std::printf("pregenerating %dx%d columns around chunk (%d, %d) into %s: %d to generate, %d already saved\n",
+                size, size, centreX, centreZ, store.path().c_str(), (int)columns.size(), skipped);
+    std::printf("%s terrain; %d job worker(s) plus the main thread\n",
+                generator == TERRAIN_DENSITY ? "density" : "heightmap", jobs.workerCount());
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point lastReport = start;
+    // At least two rows ahead, or trim() drops columns the next row still needs
+    int maxRequests = std::max(REQUESTS_PER_WORKER * jobs.workerCount(), 2 * size + 4);
+    size_t nextColumn = 0;
+    int finished = 0;
+    std::vector<FinishedColumn> done;
+    std::vector<glm::ivec2> toSave;
+    std::vector<int> indices;
+    int peakCached = 0;
+    while (finished < (int)columns.size()) {
+        while (nextColumn < columns.size() && pipeline.requestedCount() < maxRequests)
+            pipeline.request(columns[nextColumn++]);
+        pipeline.update();
+
+        done.clear();
+        pipeline.takeFinished(done);
+        if (done.empty()) {
+            pipeline.waitForProgress();
+            continue;
+        }
+        // Keeps memory to the rows in flight rather than the whole area
+        peakCached = std::max(peakCached, pipeline.cachedCount());
+        pipeline.trim();
+
+        // Through a World only for as long as the saver takes its snapshots
+        toSave.clear();
+        indices.clear();
+        for (FinishedColumn& column : done) {
+            for (size_t i = 0; i < column.sections.size(); ++i) {
+                int index = world.addChunk(column.column.x, minChunkY + (int)i, column.column.y);
+                world.chunk(index).replaceBlocks(std::move(column.sections[i]));  // new slots start unsaved
+                indices.push_back(index);
+            }
+            toSave.push_back(column.column);
+        }
+        saver.submit(world, toSave);
+        for (int index : indices)
+            world.removeChunk(index);
+        finished += (int)done.size();
+
+        if (secondsSince(lastReport) >= 1.0) {
+            lastReport = Clock::now();
+            std::printf("  %d/%d columns, %.0f chunks/s\n", finished, (int)columns.size(),
+                        finished * (maxChunkY - minChunkY + 1) / secondsSince(start));
+            std::fflush(stdout);
+        }
+    }
+    double generateSeconds = secondsSince(start);
+    saver.flush();
+    double totalSeconds = secondsSince(start);
+
+    int chunks = (int)columns.size() * (maxChunkY - minChunkY + 1);
+    std::printf("\n%d chunks (%d columns) in %.2f s: %.0f chunks/s generated, %.0f chunks/s saved to disk\n", chunks,
+                (int)columns.size(), totalSeconds, generateSeconds > 0.0 ? chunks / generateSeconds : 0.0,
+                totalSeconds > 0.0 ? chunks / totalSeconds : 0.0);
+
+    // Stage times are summed over threads; neighbours around the edge of the
+    // area are generated up to the surface stage as well
+    double stageTotal = 0.0;
+    for (int stage = STATUS_TERRAIN; stage <= STATUS_DECORATED; ++stage)
+        stageTotal += pipeline.stageStats((ChunkStatus)stage).seconds;
+    std::printf("%-10s %8s %10s %12s %7s\n", "stage", "runs", "cpu s", "us per run", "share");
+    for (int stage = STATUS_TERRAIN; stage <= STATUS_DECORATED; ++stage) {
+        StageStats stats = pipeline.stageStats((ChunkStatus)stage);
+        std::printf("%-10s %8llu %10.3f %12.1f %6.1f%%\n", chunkStatusName((ChunkStatus)stage),
+                    (unsigned long long)stats.runs, stats.seconds, stats.runs ? stats.seconds / stats.runs * 1e6 : 0.0,
+                    stageTotal > 0.0 ? 100.0 * stats.seconds / stageTotal : 0.0);
+    }
+
+    SaveStats save = saver.stats();
+    std::printf("save: %llu columns, %.1f MiB encoded, %.1f MiB written, %.1f MiB/s while busy\n",
+                (unsigned long long)save.columnsSaved, save.encodedBytes / (1024.0 * 1024.0),
+                save.writtenBytes / (1024.0 * 1024.0), save.megabytesPerSecond());
+    std::printf("pipeline: at most %d columns cached\n", peakCached);
+    JobStats jobStats = jobs.stats();
+    std::printf("jobs: %llu run, %llu stolen\n", (unsigned long long)jobStats.executed,
+                (unsigned long long)jobStats.stolen);
+    return 0;
+}